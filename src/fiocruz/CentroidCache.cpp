@@ -0,0 +1,740 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+    This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+    TerraLib is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    TerraLib is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TerraLib. See COPYING. If not, write to
+    TerraLib Team at <terralib-team@terralib.org>.
+ */
+
+/*!
+  \file fiocruz/src/fiocruz/CentroidCache.cpp
+
+  \brief This file defines the polygon centroid cache
+*/
+
+// TerraLib
+#include <terralib/dataaccess/dataset/DataSet.h>
+#include <terralib/dataaccess/dataset/DataSetType.h>
+#include <terralib/dataaccess/query/DataSetName.h>
+#include <terralib/dataaccess/query/Field.h>
+#include <terralib/dataaccess/query/FromItem.h>
+#include <terralib/dataaccess/query/Select.h>
+#include <terralib/dataaccess/utils/Utils.h>
+#include <terralib/datatype/Enums.h>
+#include <terralib/geometry/GeometryProperty.h>
+#include <terralib/geometry/LineString.h>
+#include <terralib/geometry/MultiPolygon.h>
+#include <terralib/geometry/Point.h>
+#include <terralib/geometry/Polygon.h>
+#include "CentroidCache.h"
+#include "ColumnReader.h"
+#include "flow/core/ParallelUtils.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// Boost
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+namespace
+{
+  const char CENTROID_MAGIC[8] = { 'F', 'L', 'O', 'W', 'C', 'T', 'R', 'D' };
+
+  const boost::uint32_t CENTROID_BYTE_ORDER = 0x01020304;
+
+  //number of geometries kept in memory while the points are computed
+  const std::size_t CENTROID_BLOCK_SIZE = 4096;
+
+  struct CacheHeader
+  {
+    char m_magic[8];
+    boost::uint32_t m_version;
+    boost::uint32_t m_byteOrder;
+    boost::uint64_t m_keySize;
+    boost::uint64_t m_rowCount;
+  };
+
+  /*!
+    \brief Area and centroid of the rings of a polygon, the first ring is the shell and the others are holes.
+
+    The coordinates are taken relative to the first shell point to keep the precision
+    of projected coordinates. The ring orientation is not assumed.
+
+    \return The polygon area (0 if it is degenerated).
+  */
+  double GetPolygonCentroid(const te::gm::Polygon* polygon, double& cx, double& cy)
+  {
+    double area = 0.;
+    double mx = 0.;
+    double my = 0.;
+
+    const te::gm::LineString* shell = dynamic_cast<const te::gm::LineString*>(polygon->getRingN(0));
+
+    double x0 = shell->getX(0);
+    double y0 = shell->getY(0);
+
+    for (std::size_t r = 0; r < polygon->getNumRings(); ++r)
+    {
+      const te::gm::LineString* ring = dynamic_cast<const te::gm::LineString*>(polygon->getRingN(r));
+
+      if (ring == 0 || ring->getNPoints() < 3)
+        continue;
+
+      double ringArea = 0.;
+      double ringMx = 0.;
+      double ringMy = 0.;
+
+      std::size_t n = ring->getNPoints();
+
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        std::size_t j = (i + 1) % n;
+
+        double xi = ring->getX(i) - x0;
+        double yi = ring->getY(i) - y0;
+        double xj = ring->getX(j) - x0;
+        double yj = ring->getY(j) - y0;
+
+        double cross = xi * yj - xj * yi;
+
+        ringArea += cross;
+        ringMx += (xi + xj) * cross;
+        ringMy += (yi + yj) * cross;
+      }
+
+      //the shell adds and the holes subtract, whatever their orientation
+      double sign = (ringArea < 0. ? -1. : 1.) * (r == 0 ? 1. : -1.);
+
+      area += sign * ringArea / 2.;
+      mx += sign * ringMx / 6.;
+      my += sign * ringMy / 6.;
+    }
+
+    if (area <= 0.)
+    {
+      cx = x0;
+      cy = y0;
+
+      return 0.;
+    }
+
+    cx = x0 + mx / area;
+    cy = y0 + my / area;
+
+    return area;
+  }
+
+  /*! \brief Gets the x of the crossings of the polygon rings with the horizontal line y. */
+  void GetCrossings(const te::gm::Polygon* polygon, double y, std::vector<double>& crossings)
+  {
+    crossings.clear();
+
+    for (std::size_t r = 0; r < polygon->getNumRings(); ++r)
+    {
+      const te::gm::LineString* ring = dynamic_cast<const te::gm::LineString*>(polygon->getRingN(r));
+
+      if (ring == 0)
+        continue;
+
+      std::size_t n = ring->getNPoints();
+
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        std::size_t j = (i + 1) % n;
+
+        double yi = ring->getY(i);
+        double yj = ring->getY(j);
+
+        //half open rule, so a vertex on the line is counted once
+        if ((yi > y) != (yj > y))
+        {
+          double xi = ring->getX(i);
+          double xj = ring->getX(j);
+
+          crossings.push_back(xi + (y - yi) * (xj - xi) / (yj - yi));
+        }
+      }
+    }
+
+    std::sort(crossings.begin(), crossings.end());
+  }
+
+  /*!
+    \brief Moves a point that is outside the polygon to the middle of the widest interior segment of its horizontal line.
+
+    If the line does not cross the polygon, the line through the middle of the shell extent is used.
+  */
+  void GetPointOnSurface(const te::gm::Polygon* polygon, double& x, double& y)
+  {
+    std::vector<double> crossings;
+
+    GetCrossings(polygon, y, crossings);
+
+    //odd-even rule: the point is inside if it has an odd number of crossings to its left
+    std::size_t left = std::lower_bound(crossings.begin(), crossings.end(), x) - crossings.begin();
+
+    if (left % 2 == 1)
+      return;
+
+    if (crossings.size() < 2)
+    {
+      const te::gm::LineString* shell = dynamic_cast<const te::gm::LineString*>(polygon->getRingN(0));
+
+      double minY = shell->getY(0);
+      double maxY = minY;
+
+      for (std::size_t i = 1; i < shell->getNPoints(); ++i)
+      {
+        minY = std::min(minY, shell->getY(i));
+        maxY = std::max(maxY, shell->getY(i));
+      }
+
+      y = (minY + maxY) / 2.;
+
+      GetCrossings(polygon, y, crossings);
+
+      if (crossings.size() < 2)
+        return;
+    }
+
+    double width = -1.;
+
+    for (std::size_t i = 0; i + 1 < crossings.size(); i += 2)
+    {
+      if (crossings[i + 1] - crossings[i] > width)
+      {
+        width = crossings[i + 1] - crossings[i];
+        x = (crossings[i] + crossings[i + 1]) / 2.;
+      }
+    }
+  }
+}
+
+te::qt::plugins::fiocruz::CentroidTable::CentroidTable()
+{
+}
+
+te::qt::plugins::fiocruz::CentroidTable::~CentroidTable()
+{
+}
+
+std::size_t te::qt::plugins::fiocruz::CentroidTable::size() const
+{
+  return m_x.size();
+}
+
+int te::qt::plugins::fiocruz::CentroidTable::getIndex(const std::string& id) const
+{
+  return m_ids.getIndex(id);
+}
+
+bool te::qt::plugins::fiocruz::CentroidTable::getPoint(const std::string& id, double& x, double& y) const
+{
+  int row = m_ids.getIndex(id);
+
+  if (row == -1)
+    return false;
+
+  x = m_x[row];
+  y = m_y[row];
+
+  return true;
+}
+
+const std::string& te::qt::plugins::fiocruz::CentroidTable::getId(std::size_t row) const
+{
+  return m_ids.getId((int)row);
+}
+
+double te::qt::plugins::fiocruz::CentroidTable::getX(std::size_t row) const
+{
+  return m_x[row];
+}
+
+double te::qt::plugins::fiocruz::CentroidTable::getY(std::size_t row) const
+{
+  return m_y[row];
+}
+
+void te::qt::plugins::fiocruz::CentroidTable::add(const std::string& id, double x, double y)
+{
+  bool added;
+
+  m_ids.add(id, added);
+
+  if (!added)
+    return;
+
+  m_x.push_back(x);
+  m_y.push_back(y);
+}
+
+te::qt::plugins::fiocruz::CentroidCache::CentroidCache()
+{
+  m_numThreads = 0;
+
+  try
+  {
+    m_directory = (boost::filesystem::temp_directory_path() / "fiocruz_centroids").string();
+  }
+  catch (const boost::filesystem::filesystem_error&)
+  {
+  }
+}
+
+te::qt::plugins::fiocruz::CentroidCache::~CentroidCache()
+{
+}
+
+boost::shared_ptr<const te::qt::plugins::fiocruz::CentroidTable> te::qt::plugins::fiocruz::CentroidCache::getTable(te::da::DataSourcePtr dataSource, const std::string& dataSetName, const std::string& idColumnName)
+{
+  std::string stamp = getStamp(dataSource, dataSetName);
+
+  if (stamp.empty())
+  {
+    std::auto_ptr<te::da::DataSet> dataSet = getDataSet(dataSource, dataSetName, idColumnName);
+
+    return compute(dataSet.get(), idColumnName);
+  }
+
+  std::string key = dataSource->getType() + "\n" + dataSetName + "\n" + idColumnName + "\n" + stamp;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<std::string, boost::shared_ptr<const CentroidTable> >::iterator it = m_tables.find(key);
+
+    if (it != m_tables.end())
+      return it->second;
+  }
+
+  std::string fileName = getFileName(key);
+
+  boost::shared_ptr<const CentroidTable> table;
+
+  {
+    boost::shared_ptr<CentroidTable> loaded(new CentroidTable);
+
+    if (!fileName.empty() && load(fileName, key, *loaded))
+      table = loaded;
+  }
+
+  if (!table)
+  {
+    std::auto_ptr<te::da::DataSet> dataSet = getDataSet(dataSource, dataSetName, idColumnName);
+
+    table = compute(dataSet.get(), idColumnName);
+
+    if (!fileName.empty())
+      save(fileName, key, *table);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_tables[key] = table;
+
+  return table;
+}
+
+boost::shared_ptr<const te::qt::plugins::fiocruz::CentroidTable> te::qt::plugins::fiocruz::CentroidCache::compute(te::da::DataSet* dataSet, const std::string& idColumnName)
+{
+  boost::shared_ptr<CentroidTable> table(new CentroidTable);
+
+  if (dataSet == 0)
+    return table;
+
+  ColumnReader idReader(dataSet, idColumnName);
+
+  std::size_t geomPos = te::da::GetFirstPropertyPos(dataSet, te::dt::GEOMETRY_TYPE);
+
+  if (!idReader.isValid() || geomPos == std::string::npos)
+    return table;
+
+  std::vector<std::string> ids;
+  boost::ptr_vector<te::gm::Geometry> geoms;
+
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<unsigned char> valid;
+
+  dataSet->moveBeforeFirst();
+
+  bool hasNext = dataSet->moveNext();
+
+  //the geometries are read in blocks, the data set is only accessed by this thread
+  while (hasNext)
+  {
+    ids.clear();
+    geoms.clear();
+
+    while (hasNext && geoms.size() < CENTROID_BLOCK_SIZE)
+    {
+      if (!dataSet->isNull(geomPos))
+      {
+        std::auto_ptr<te::gm::Geometry> geom = dataSet->getGeometry(geomPos);
+
+        if (geom.get())
+        {
+          ids.push_back(idReader.getString());
+          geoms.push_back(geom.release());
+        }
+      }
+
+      hasNext = dataSet->moveNext();
+    }
+
+    std::size_t n = geoms.size();
+
+    x.assign(n, 0.);
+    y.assign(n, 0.);
+    valid.assign(n, 0);
+
+    ParallelFor(n, m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+    {
+      for (std::size_t i = begin; i < end; ++i)
+        valid[i] = GetRepresentativePoint(&geoms[i], x[i], y[i]) ? 1 : 0;
+    });
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (valid[i])
+        table->add(ids[i], x[i], y[i]);
+    }
+  }
+
+  return table;
+}
+
+void te::qt::plugins::fiocruz::CentroidCache::setDirectory(const std::string& directory)
+{
+  m_directory = directory;
+}
+
+const std::string& te::qt::plugins::fiocruz::CentroidCache::getDirectory() const
+{
+  return m_directory;
+}
+
+void te::qt::plugins::fiocruz::CentroidCache::setNumberOfThreads(std::size_t numThreads)
+{
+  m_numThreads = numThreads;
+}
+
+void te::qt::plugins::fiocruz::CentroidCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_tables.clear();
+}
+
+bool te::qt::plugins::fiocruz::CentroidCache::GetRepresentativePoint(const te::gm::Geometry* geom, double& x, double& y)
+{
+  if (geom == 0)
+    return false;
+
+  const te::gm::Point* point = dynamic_cast<const te::gm::Point*>(geom);
+
+  if (point)
+  {
+    x = point->getX();
+    y = point->getY();
+
+    return true;
+  }
+
+  //the largest part of a multi polygon, a polygon is its only part
+  const te::gm::Polygon* part = 0;
+  double partArea = -1.;
+
+  std::vector<const te::gm::Polygon*> parts;
+
+  if (dynamic_cast<const te::gm::Polygon*>(geom))
+  {
+    parts.push_back(dynamic_cast<const te::gm::Polygon*>(geom));
+  }
+  else if (dynamic_cast<const te::gm::MultiPolygon*>(geom))
+  {
+    const te::gm::MultiPolygon* multiPolygon = dynamic_cast<const te::gm::MultiPolygon*>(geom);
+
+    for (std::size_t i = 0; i < multiPolygon->getNumGeometries(); ++i)
+      parts.push_back(dynamic_cast<const te::gm::Polygon*>(multiPolygon->getGeometryN(i)));
+  }
+
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    if (parts[i] == 0 || parts[i]->getNumRings() == 0)
+      continue;
+
+    const te::gm::LineString* shell = dynamic_cast<const te::gm::LineString*>(parts[i]->getRingN(0));
+
+    if (shell == 0 || shell->getNPoints() == 0)
+      continue;
+
+    double cx;
+    double cy;
+
+    double area = GetPolygonCentroid(parts[i], cx, cy);
+
+    if (area > partArea)
+    {
+      part = parts[i];
+      partArea = area;
+
+      x = cx;
+      y = cy;
+    }
+  }
+
+  if (part == 0)
+    return false;
+
+  GetPointOnSurface(part, x, y);
+
+  return true;
+}
+
+std::auto_ptr<te::da::DataSet> te::qt::plugins::fiocruz::CentroidCache::getDataSet(te::da::DataSourcePtr dataSource, const std::string& dataSetName, const std::string& idColumnName)
+{
+  std::auto_ptr<te::da::DataSetType> dataSetType = dataSource->getDataSetType(dataSetName);
+
+  te::gm::GeometryProperty* geomProperty = te::da::GetFirstGeomProperty(dataSetType.get());
+
+  if (geomProperty == 0)
+    return std::auto_ptr<te::da::DataSet>();
+
+  te::da::Fields* fields = new te::da::Fields;
+  fields->push_back(new te::da::Field(idColumnName));
+  fields->push_back(new te::da::Field(geomProperty->getName()));
+
+  te::da::FromItem* fromItem = new te::da::DataSetName(dataSetName);
+  te::da::From* from = new te::da::From;
+  from->push_back(fromItem);
+
+  te::da::Select select(fields);
+  select.setFrom(from);
+
+  return dataSource->query(select);
+}
+
+std::string te::qt::plugins::fiocruz::CentroidCache::getStamp(te::da::DataSourcePtr dataSource, const std::string& dataSetName)
+{
+  const std::map<std::string, std::string>& connInfo = dataSource->getConnectionInfo();
+
+  std::map<std::string, std::string>::const_iterator it = connInfo.find("URI");
+
+  if (it == connInfo.end())
+    return "";
+
+  //the data set files are the ones with the same stem of the URI file (e.g. .shp, .dbf, .shx)
+  //or, for a directory URI, the ones named after the data set
+  std::vector<std::string> entries;
+
+  try
+  {
+    boost::filesystem::path uri(it->second);
+
+    boost::filesystem::path dir = uri;
+    std::string stem = dataSetName;
+
+    if (boost::filesystem::is_regular_file(uri))
+    {
+      dir = uri.parent_path();
+      stem = uri.stem().string();
+    }
+    else if (!boost::filesystem::is_directory(uri))
+    {
+      return "";
+    }
+
+    for (boost::filesystem::directory_iterator file(dir), end; file != end; ++file)
+    {
+      if (!boost::filesystem::is_regular_file(file->path()) || file->path().stem().string() != stem)
+        continue;
+
+      std::ostringstream entry;
+      entry << boost::filesystem::absolute(file->path()).string() << ":" << boost::filesystem::last_write_time(file->path()) << ":" << boost::filesystem::file_size(file->path());
+
+      entries.push_back(entry.str());
+    }
+  }
+  catch (const boost::filesystem::filesystem_error&)
+  {
+    return "";
+  }
+
+  std::sort(entries.begin(), entries.end());
+
+  std::string stamp;
+
+  for (std::size_t i = 0; i < entries.size(); ++i)
+    stamp += entries[i] + "\n";
+
+  return stamp;
+}
+
+std::string te::qt::plugins::fiocruz::CentroidCache::getFileName(const std::string& key) const
+{
+  if (m_directory.empty())
+    return "";
+
+  std::ostringstream name;
+  name << std::hex << (boost::uint64_t)IdHash()(key) << ".ctd";
+
+  return (boost::filesystem::path(m_directory) / name.str()).string();
+}
+
+bool te::qt::plugins::fiocruz::CentroidCache::load(const std::string& fileName, const std::string& key, CentroidTable& table)
+{
+  std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+
+  if (!in.is_open())
+    return false;
+
+  boost::uint64_t fileSize = (boost::uint64_t)in.tellg();
+
+  in.seekg(0, std::ios::beg);
+
+  CacheHeader header;
+
+  if (fileSize < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    return false;
+
+  if (memcmp(header.m_magic, CENTROID_MAGIC, sizeof(CENTROID_MAGIC)) != 0 || header.m_version != FIOCRUZ_CENTROID_CACHE_VERSION ||
+      header.m_byteOrder != CENTROID_BYTE_ORDER || header.m_keySize != key.size())
+    return false;
+
+  //each row uses two coordinates and an id size, a larger count comes from a corrupt file
+  boost::uint64_t available = fileSize - sizeof(header);
+
+  if (key.size() > available || header.m_rowCount > (available - key.size()) / (2 * sizeof(double) + sizeof(boost::uint32_t)))
+    return false;
+
+  boost::uint64_t idBytes = available - key.size() - header.m_rowCount * 2 * sizeof(double);
+
+  try
+  {
+    //the key is stored in the file, so a hash collision is not taken as a hit
+    std::string fileKey(key.size(), '\0');
+
+    if (!key.empty() && (!in.read(&fileKey[0], fileKey.size()) || fileKey != key))
+      return false;
+
+    std::size_t rowCount = (std::size_t)header.m_rowCount;
+
+    std::vector<double> x(rowCount);
+    std::vector<double> y(rowCount);
+
+    if (rowCount > 0)
+    {
+      if (!in.read(reinterpret_cast<char*>(&x[0]), rowCount * sizeof(double)) ||
+          !in.read(reinterpret_cast<char*>(&y[0]), rowCount * sizeof(double)))
+        return false;
+    }
+
+    std::string id;
+
+    for (std::size_t i = 0; i < rowCount; ++i)
+    {
+      boost::uint32_t idSize;
+
+      if (idBytes < sizeof(idSize) || !in.read(reinterpret_cast<char*>(&idSize), sizeof(idSize)))
+        return false;
+
+      idBytes -= sizeof(idSize);
+
+      if (idSize > idBytes)
+        return false;
+
+      idBytes -= idSize;
+
+      id.resize(idSize);
+
+      if (idSize > 0 && !in.read(&id[0], idSize))
+        return false;
+
+      table.add(id, x[i], y[i]);
+    }
+
+    return table.size() == rowCount;
+  }
+  catch (std::exception&)
+  {
+    //allocation failures (bad_alloc, length_error), the table is computed again
+    return false;
+  }
+}
+
+void te::qt::plugins::fiocruz::CentroidCache::save(const std::string& fileName, const std::string& key, const CentroidTable& table)
+{
+  //written to a temporary file and renamed, so a reader never sees a partial file
+  std::string tmpFileName = fileName + ".tmp";
+
+  try
+  {
+    boost::filesystem::create_directories(boost::filesystem::path(fileName).parent_path());
+
+    std::ofstream out(tmpFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!out.is_open())
+      return;
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, CENTROID_MAGIC, sizeof(CENTROID_MAGIC));
+    header.m_version = FIOCRUZ_CENTROID_CACHE_VERSION;
+    header.m_byteOrder = CENTROID_BYTE_ORDER;
+    header.m_keySize = key.size();
+    header.m_rowCount = table.size();
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(key.data(), key.size());
+
+    if (table.size() > 0)
+    {
+      out.write(reinterpret_cast<const char*>(&table.m_x[0]), table.size() * sizeof(double));
+      out.write(reinterpret_cast<const char*>(&table.m_y[0]), table.size() * sizeof(double));
+    }
+
+    for (std::size_t i = 0; i < table.size(); ++i)
+    {
+      const std::string& id = table.getId(i);
+
+      boost::uint32_t idSize = (boost::uint32_t)id.size();
+
+      out.write(reinterpret_cast<const char*>(&idSize), sizeof(idSize));
+      out.write(id.data(), id.size());
+    }
+
+    out.close();
+
+    if (out.fail())
+    {
+      boost::filesystem::remove(tmpFileName);
+      return;
+    }
+
+    boost::filesystem::rename(tmpFileName, fileName);
+  }
+  catch (const boost::filesystem::filesystem_error&)
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove(tmpFileName, ec);
+  }
+}
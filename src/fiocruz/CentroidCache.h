@@ -0,0 +1,202 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+    This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+    TerraLib is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    TerraLib is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TerraLib. See COPYING. If not, write to
+    TerraLib Team at <terralib-team@terralib.org>.
+ */
+
+/*!
+  \file fiocruz/src/fiocruz/CentroidCache.h
+
+  \brief This file defines the polygon centroid cache
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_CENTROIDCACHE_H
+#define __FIOCRUZ_INTERNAL_CENTROIDCACHE_H
+
+// TerraLib
+#include <terralib/common/Singleton.h>
+#include <terralib/dataaccess/datasource/DataSource.h>
+
+#include "Config.h"
+#include "flow/core/IdDictionary.h"
+
+// STL
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/shared_ptr.hpp>
+
+/*!
+  \def FIOCRUZ_CENTROID_CACHE_VERSION
+
+  \brief Version of the centroid cache file format, files with other versions are computed again.
+*/
+#define FIOCRUZ_CENTROID_CACHE_VERSION 1
+
+namespace te
+{
+  namespace da { class DataSet; }
+
+  namespace gm { class Geometry; }
+
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+          \class CentroidTable
+
+          \brief Representative point of each object of a polygon data set, addressed by the object id.
+
+          The rows keep the data set order, objects without a polygon or point geometry
+          are not stored and, if an id is repeated, the first object is kept.
+        */
+        class CentroidTable
+        {
+          friend class CentroidCache;
+
+          public:
+
+            CentroidTable();
+
+            ~CentroidTable();
+
+          public:
+
+            std::size_t size() const;
+
+            /*! \brief Returns the row of an object id or -1. */
+            int getIndex(const std::string& id) const;
+
+            /*! \brief Gets the point of an object id, returns false if the id is not in the table. */
+            bool getPoint(const std::string& id, double& x, double& y) const;
+
+            const std::string& getId(std::size_t row) const;
+
+            double getX(std::size_t row) const;
+
+            double getY(std::size_t row) const;
+
+          protected:
+
+            /*! \brief Adds a row, nothing is done if the id is already in the table. */
+            void add(const std::string& id, double x, double y);
+
+          protected:
+
+            IdDictionary<std::string> m_ids;    //!< Object id to row
+            std::vector<double> m_x;            //!< Point x coordinate
+            std::vector<double> m_y;            //!< Point y coordinate
+        };
+
+        /*!
+          \class CentroidCache
+
+          \brief Keeps the representative points of polygon data sets between runs.
+
+          The tables are keyed by the data source, the data set name, the id column and
+          a modification stamp (the time and size of the data set files). They are kept
+          in memory and persisted in the cache directory, so the points of a data set
+          are computed again only when its files change. Data sets that are not file
+          based (without a stamp) are computed on every request.
+
+          Only the id and geometry columns are read, in blocks of geometries that are
+          released as soon as their points are computed in parallel. The point of a polygon is the centroid of its largest part, or a point
+          on its surface when the centroid falls outside the part (see GetRepresentativePoint).
+        */
+        class CentroidCache : public te::common::Singleton<CentroidCache>
+        {
+          friend class te::common::Singleton<CentroidCache>;
+
+          public:
+
+            /*!
+              \brief Returns the table of a data set, computed and stored if it is not cached.
+
+              \param dataSource     Data source of the polygon data set
+              \param dataSetName    Data set name
+              \param idColumnName   Column with the object ids, numeric ids are converted to string
+
+              \return The table, it is shared with the cache and must not be changed.
+            */
+            boost::shared_ptr<const CentroidTable> getTable(te::da::DataSourcePtr dataSource, const std::string& dataSetName, const std::string& idColumnName);
+
+            /*! \brief Computes the table of a data set without any caching, the data set is read from its first row. */
+            boost::shared_ptr<const CentroidTable> compute(te::da::DataSet* dataSet, const std::string& idColumnName);
+
+            /*! \brief Defines the cache directory, an empty directory keeps the tables only in memory. */
+            void setDirectory(const std::string& directory);
+
+            const std::string& getDirectory() const;
+
+            /*! \brief Defines the number of threads used to compute the points, 0 (default) uses one thread per core. */
+            void setNumberOfThreads(std::size_t numThreads);
+
+            /*! \brief Removes the tables kept in memory, the files are not removed. */
+            void clear();
+
+            /*!
+              \brief Gets the representative point of a point, polygon or multi polygon geometry.
+
+              The point of a polygon is its area centroid (holes are subtracted). For a multi
+              polygon only the part with the largest area is used, so islands do not move the
+              point to the sea. If the centroid is not inside the part, the middle of the widest
+              interior segment of the horizontal line through the centroid is used.
+
+              \return False for other geometry types.
+            */
+            static bool GetRepresentativePoint(const te::gm::Geometry* geom, double& x, double& y);
+
+          protected:
+
+            CentroidCache();
+
+            ~CentroidCache();
+
+            /*! \brief Reads only the id and the geometry columns of a data set, the other columns are not loaded. */
+            std::auto_ptr<te::da::DataSet> getDataSet(te::da::DataSourcePtr dataSource, const std::string& dataSetName, const std::string& idColumnName);
+
+            /*! \brief Returns the modification stamp of a file based data set or an empty string. */
+            std::string getStamp(te::da::DataSourcePtr dataSource, const std::string& dataSetName);
+
+            std::string getFileName(const std::string& key) const;
+
+            /*! \brief Reads a cache file, returns false if it does not exist, if it was written for another key or if it is truncated or corrupt. */
+            bool load(const std::string& fileName, const std::string& key, CentroidTable& table);
+
+            /*! \brief Writes a cache file, errors are ignored because the table can always be computed again. */
+            void save(const std::string& fileName, const std::string& key, const CentroidTable& table);
+
+          protected:
+
+            std::map<std::string, boost::shared_ptr<const CentroidTable> > m_tables;   //!< Tables kept in memory, by key
+            std::string m_directory;                                                  //!< Cache directory
+            std::size_t m_numThreads;                                                 //!< Number of threads used to compute the points
+            std::mutex m_mutex;                                                       //!< Protects m_tables
+        };
+
+      } // end namespace fiocruz
+    }   // end namespace plugins
+  }     // end namespace qt
+}       // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_CENTROIDCACHE_H
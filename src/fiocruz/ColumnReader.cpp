@@ -0,0 +1,275 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+    This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+    TerraLib is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    TerraLib is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TerraLib. See COPYING. If not, write to
+    TerraLib Team at <terralib-team@terralib.org>.
+ */
+
+/*!
+  \file fiocruz/src/fiocruz/ColumnReader.cpp
+
+  \brief This file defines the class ColumnReader
+*/
+
+// TerraLib
+#include <terralib/common/Exception.h>
+#include <terralib/common/Translator.h>
+#include <terralib/dataaccess/utils/Utils.h>
+#include <terralib/datatype/Enums.h>
+#include "ColumnReader.h"
+
+// STL
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+// Boost
+#include <boost/lexical_cast.hpp>
+
+te::qt::plugins::fiocruz::ColumnReader::ColumnReader() :
+  m_dataSet(0),
+  m_idx(0),
+  m_type(te::dt::UNKNOWN_TYPE),
+  m_valid(false)
+{
+}
+
+te::qt::plugins::fiocruz::ColumnReader::ColumnReader(te::da::DataSet* dataSet, std::size_t idx) :
+  m_dataSet(0),
+  m_idx(0),
+  m_type(te::dt::UNKNOWN_TYPE),
+  m_valid(false)
+{
+  init(dataSet, (int)idx);
+}
+
+te::qt::plugins::fiocruz::ColumnReader::ColumnReader(te::da::DataSet* dataSet, const std::string& name) :
+  m_dataSet(0),
+  m_idx(0),
+  m_type(te::dt::UNKNOWN_TYPE),
+  m_valid(false)
+{
+  if (dataSet)
+    init(dataSet, te::da::GetPropertyIndex(dataSet, name));
+}
+
+te::qt::plugins::fiocruz::ColumnReader::~ColumnReader()
+{
+}
+
+void te::qt::plugins::fiocruz::ColumnReader::init(te::da::DataSet* dataSet, int idx)
+{
+  if (!dataSet || idx < 0 || idx >= (int)dataSet->getNumProperties())
+    return;
+
+  m_dataSet = dataSet;
+  m_idx = (std::size_t)idx;
+  m_type = dataSet->getPropertyDataType(m_idx);
+  m_valid = true;
+}
+
+bool te::qt::plugins::fiocruz::ColumnReader::isValid() const
+{
+  return m_valid;
+}
+
+bool te::qt::plugins::fiocruz::ColumnReader::isNumeric() const
+{
+  return isInteger() || m_type == te::dt::FLOAT_TYPE || m_type == te::dt::DOUBLE_TYPE || m_type == te::dt::NUMERIC_TYPE;
+}
+
+bool te::qt::plugins::fiocruz::ColumnReader::isInteger() const
+{
+  return m_type == te::dt::INT16_TYPE || m_type == te::dt::INT32_TYPE || m_type == te::dt::INT64_TYPE ||
+         m_type == te::dt::UINT16_TYPE || m_type == te::dt::UINT32_TYPE || m_type == te::dt::UINT64_TYPE;
+}
+
+std::size_t te::qt::plugins::fiocruz::ColumnReader::getIndex() const
+{
+  return m_idx;
+}
+
+int te::qt::plugins::fiocruz::ColumnReader::getType() const
+{
+  return m_type;
+}
+
+bool te::qt::plugins::fiocruz::ColumnReader::isNull() const
+{
+  if (!m_valid)
+    return true;
+
+  return m_dataSet->isNull(m_idx);
+}
+
+int te::qt::plugins::fiocruz::ColumnReader::getInt32() const
+{
+  if (!m_valid)
+    return 0;
+
+  switch (m_type)
+  {
+    case te::dt::INT16_TYPE:
+    case te::dt::UINT16_TYPE:
+      return m_dataSet->isNull(m_idx) ? 0 : (int)m_dataSet->getInt16(m_idx);
+
+    case te::dt::INT32_TYPE:
+    case te::dt::UINT32_TYPE:
+      return m_dataSet->isNull(m_idx) ? 0 : (int)m_dataSet->getInt32(m_idx);
+
+    default:
+      return (int)getInt64();
+  }
+}
+
+int te::qt::plugins::fiocruz::ColumnReader::getId() const
+{
+  if (!m_valid || m_dataSet->isNull(m_idx))
+    return 0;
+
+  switch (m_type)
+  {
+    case te::dt::INT16_TYPE:
+    case te::dt::UINT16_TYPE:
+    case te::dt::INT32_TYPE:
+      return getInt32();
+
+    case te::dt::UINT32_TYPE:
+    case te::dt::INT64_TYPE:
+    case te::dt::UINT64_TYPE:
+    {
+      boost::int64_t value = getInt64();
+
+      if (value < INT_MIN || value > INT_MAX)
+        throw te::common::Exception(TE_TR("The id column has a value out of the integer range, only 32 bits integer ids are supported."));
+
+      return (int)value;
+    }
+
+    case te::dt::FLOAT_TYPE:
+    case te::dt::DOUBLE_TYPE:
+    case te::dt::NUMERIC_TYPE:
+    {
+      double value = getDouble();
+
+      if (value != std::floor(value) || value < INT_MIN || value > INT_MAX)
+        throw te::common::Exception(TE_TR("The id column has a value that is not an integer, only integer ids are supported."));
+
+      return (int)value;
+    }
+
+    default:
+    {
+      //text ids must be integer numbers, other text would collapse to the same id
+      std::string str = m_dataSet->getAsString(m_idx);
+
+      const char* begin = str.c_str();
+      char* end = 0;
+
+      errno = 0;
+
+      long long value = strtoll(begin, &end, 10);
+
+      while (*end == ' ')
+        ++end;
+
+      if (end == begin || *end != '\0' || errno == ERANGE || value < INT_MIN || value > INT_MAX)
+        throw te::common::Exception(TE_TR("The id column has a value that is not an integer, only integer ids are supported."));
+
+      return (int)value;
+    }
+  }
+}
+
+boost::int64_t te::qt::plugins::fiocruz::ColumnReader::getInt64() const
+{
+  if (!m_valid || m_dataSet->isNull(m_idx))
+    return 0;
+
+  switch (m_type)
+  {
+    case te::dt::INT16_TYPE:
+    case te::dt::UINT16_TYPE:
+      return (boost::int64_t)m_dataSet->getInt16(m_idx);
+
+    case te::dt::INT32_TYPE:
+    case te::dt::UINT32_TYPE:
+      return (boost::int64_t)m_dataSet->getInt32(m_idx);
+
+    case te::dt::INT64_TYPE:
+    case te::dt::UINT64_TYPE:
+      return (boost::int64_t)m_dataSet->getInt64(m_idx);
+
+    case te::dt::FLOAT_TYPE:
+      return (boost::int64_t)m_dataSet->getFloat(m_idx);
+
+    case te::dt::DOUBLE_TYPE:
+      return (boost::int64_t)m_dataSet->getDouble(m_idx);
+
+    case te::dt::NUMERIC_TYPE:
+      return (boost::int64_t)atof(m_dataSet->getNumeric(m_idx).c_str());
+
+    default:
+      return (boost::int64_t)strtoll(m_dataSet->getAsString(m_idx).c_str(), 0, 10);
+  }
+}
+
+double te::qt::plugins::fiocruz::ColumnReader::getDouble() const
+{
+  if (!m_valid || m_dataSet->isNull(m_idx))
+    return 0.;
+
+  switch (m_type)
+  {
+    case te::dt::INT16_TYPE:
+    case te::dt::UINT16_TYPE:
+      return (double)m_dataSet->getInt16(m_idx);
+
+    case te::dt::INT32_TYPE:
+    case te::dt::UINT32_TYPE:
+      return (double)m_dataSet->getInt32(m_idx);
+
+    case te::dt::INT64_TYPE:
+    case te::dt::UINT64_TYPE:
+      return (double)m_dataSet->getInt64(m_idx);
+
+    case te::dt::FLOAT_TYPE:
+      return (double)m_dataSet->getFloat(m_idx);
+
+    case te::dt::DOUBLE_TYPE:
+      return m_dataSet->getDouble(m_idx);
+
+    case te::dt::NUMERIC_TYPE:
+      return atof(m_dataSet->getNumeric(m_idx).c_str());
+
+    default:
+      return atof(m_dataSet->getAsString(m_idx).c_str());
+  }
+}
+
+std::string te::qt::plugins::fiocruz::ColumnReader::getString() const
+{
+  if (!m_valid || m_dataSet->isNull(m_idx))
+    return "";
+
+  if (m_type == te::dt::STRING_TYPE)
+    return m_dataSet->getString(m_idx);
+
+  if (isInteger())
+    return boost::lexical_cast<std::string>(getInt64());
+
+  return m_dataSet->getAsString(m_idx);
+}
@@ -0,0 +1,141 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+    This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+    TerraLib is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    TerraLib is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TerraLib. See COPYING. If not, write to
+    TerraLib Team at <terralib-team@terralib.org>.
+ */
+
+/*!
+  \file fiocruz/src/fiocruz/ColumnReader.h
+
+  \brief This file defines the class ColumnReader
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_COLUMNREADER_H
+#define __FIOCRUZ_INTERNAL_COLUMNREADER_H
+
+// TerraLib
+#include <terralib/dataaccess/dataset/DataSet.h>
+
+#include "Config.h"
+
+// STL
+#include <string>
+
+// Boost
+#include <boost/cstdint.hpp>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+          \class ColumnReader
+
+          \brief Reads the values of one data set column using its native type.
+
+          The column type is checked only once, when the reader is created. Numeric
+          columns are read with getInt16/getInt32/getInt64/getFloat/getDouble and
+          textual columns are only read as strings (and parsed) when the caller asks
+          for a numeric value from them. Null values are returned as 0 or as an
+          empty string.
+        */
+        class ColumnReader
+        {
+          public:
+
+            ColumnReader();
+
+            /*!
+              \brief Constructor.
+
+              \param dataSet  The data set, it is not owned by the reader
+              \param idx      The column position
+            */
+            ColumnReader(te::da::DataSet* dataSet, std::size_t idx);
+
+            /*!
+              \brief Constructor.
+
+              \param dataSet  The data set, it is not owned by the reader
+              \param name     The column name
+            */
+            ColumnReader(te::da::DataSet* dataSet, const std::string& name);
+
+            ~ColumnReader();
+
+          public:
+
+            /*! \brief Returns false if the reader is not associated to a valid column. */
+            bool isValid() const;
+
+            /*! \brief Returns true if the column has a integer or floating point type. */
+            bool isNumeric() const;
+
+            /*! \brief Returns true if the column has a integer type. */
+            bool isInteger() const;
+
+            /*! \brief Returns the column position. */
+            std::size_t getIndex() const;
+
+            /*! \brief Returns the column type. */
+            int getType() const;
+
+            bool isNull() const;
+
+            /*! \brief Reads the current value as a 32 bits integer (floating point values are truncated). */
+            int getInt32() const;
+
+            /*!
+              \brief Reads the current value as a vertex id, a null value is read as 0.
+
+              The flow graph keys its vertices by 32 bits integers, so text and floating point
+              values are accepted only if they are integer numbers in that range.
+
+              \exception te::common::Exception If the value is not an integer or is out of the 32 bits range.
+            */
+            int getId() const;
+
+            /*! \brief Reads the current value as a 64 bits integer (floating point values are truncated). */
+            boost::int64_t getInt64() const;
+
+            /*! \brief Reads the current value as a double, without any truncation. */
+            double getDouble() const;
+
+            /*! \brief Reads the current value as string, numeric values are converted. */
+            std::string getString() const;
+
+          protected:
+
+            void init(te::da::DataSet* dataSet, int idx);
+
+          protected:
+
+            te::da::DataSet* m_dataSet;   //!< The data set (not owned)
+            std::size_t m_idx;            //!< Column position
+            int m_type;                   //!< Column type
+            bool m_valid;                 //!< Flag used to indicate that the column exists
+        };
+
+      } // end namespace fiocruz
+    }   // end namespace plugins
+  }     // end namespace qt
+}       // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_COLUMNREADER_H
@@ -25,25 +25,39 @@ TerraLib Team at <terralib-team@terralib.org>.
 
 
 #include "CalculateMainFlow.h"
+#include "FlowDominance.h"
+#include "core/DisjointSet.h"
+#include "core/ParallelUtils.h"
 
-//terralib
-#include <terralib/datatype/SimpleData.h>
-#include <terralib/datatype/SimpleProperty.h>
-#include <terralib/geometry/GeometryProperty.h>
-#include <terralib/graph/core/AbstractGraph.h>
-#include <terralib/graph/Globals.h>
-#include <terralib/graph/core/AbstractGraphFactory.h>
-#include <terralib/graph/core/GraphMetadata.h>
-#include <terralib/graph/core/Edge.h>
-#include <terralib/graph/core/Vertex.h>
-#include <terralib/graph/iterator/MemoryIterator.h>
+// TerraLib
+#include <terralib/common/Exception.h>
+#include <terralib/common/Translator.h>
 
 // STL
+#include <algorithm>
+#include <cassert>
+#include <functional>
 #include <queue>
 
+namespace
+{
+  te::qt::plugins::fiocruz::MainFlowParameters MakeParameters(double dominanceRelation, bool checkLocalDominance, double localDominanceValue)
+  {
+    te::qt::plugins::fiocruz::MainFlowParameters params;
+    params.m_dominanceRelation = dominanceRelation;
+    params.m_checkLocalDominance = checkLocalDominance;
+    params.m_localDominanceValue = localDominanceValue;
+
+    return params;
+  }
+}
 
 te::qt::plugins::fiocruz::CalculateMainFlow::CalculateMainFlow()
 {
+  m_dominanceType = DOMINANCE_INPUTFLOW;
+  m_hasDominanceType = false;
+  m_numThreads = 1;
+  m_rankCount = 0;
 }
 
 te::qt::plugins::fiocruz::CalculateMainFlow::~CalculateMainFlow()
@@ -51,296 +65,831 @@ te::qt::plugins::fiocruz::CalculateMainFlow::~CalculateMainFlow()
 
 }
 
-void te::qt::plugins::fiocruz::CalculateMainFlow::calculate(te::graph::BidirectionalGraph* biGraph, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, bool addStatisticsColumns)
+void te::qt::plugins::fiocruz::CalculateMainFlow::calculate(FlowGraph* graph, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, bool addStatisticsColumns)
 {
+  assert(graph);
+
   //add new properties
-  buildGraph(biGraph, addStatisticsColumns);
+  buildGraph(graph, addStatisticsColumns);
+
+  MainFlowParameters params = MakeParameters(dominanceRelation, checkLocalDominance, localDominanceValue);
 
-  int mainFlowIdx = getEdgeAttrIdx(biGraph, "main_flow");
+  std::vector<unsigned char>& mainFlow = graph->getMainFlow();
 
-  //iterate over the graph
-  std::auto_ptr<te::graph::MemoryIterator> memIt(new te::graph::MemoryIterator(biGraph));
+  std::vector<unsigned char> isRoot(graph->getVertexCount(), 0);
 
-  te::graph::Vertex* vertex = memIt->getFirstVertex();
+  //the rank columns of a previous calculation would no more match the main flows
+  if (m_rankCount > 0)
+    graph->initFlowRank();
+  else if (graph->hasFlowRank())
+    graph->clearFlowRank();
 
-  while (vertex)
+  //each vertex is independent: its main flow is one of its own output edges
+  ParallelFor(graph->getVertexCount(), m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
   {
-    //get output edges from this vertex
-    std::vector<te::graph::Edge*> outEdges = biGraph->getOutEdges(vertex->getId());
+    std::vector<int> buffer;
 
-    if (!outEdges.empty())
+    for (std::size_t v = begin; v < end; ++v)
     {
-      //get the edge with the higher value of weight
-      te::graph::Edge* edge = getHighWeightEdge(biGraph, outEdges);
+      if (m_rankCount > 0)
+        rankFlows(graph, (int)v, buffer);
+
+      //get the output edge with the higher value of weight
+      OutFlowSummary summary = summarizeOutFlows(graph, (int)v);
+
+      if (summary.m_mainEdge == -1)
+        continue;
 
       //change value of main flow attr to 1
-      edge->addAttribute(mainFlowIdx, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(1));
+      mainFlow[summary.m_mainEdge] = 1;
+
+      isRoot[v] = checkRoot(graph, (int)v, summary, params) ? 1 : 0;
     }
+  });
+
+  //get roots, in vertex order
+  std::vector<int> roots;
 
-    vertex = memIt->getNextVertex();
+  for (std::size_t v = 0; v < isRoot.size(); ++v)
+  {
+    if (isRoot[v])
+      roots.push_back((int)v);
   }
 
+  //set level info into graph
+  buildLevel(graph, roots, graph->getLevel());
+
+  if (graph->hasMainFlowStatistics())
+    buildStatistics(graph, params);
+}
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::update(FlowGraph* graph, const std::vector<int>& vertices, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, bool addStatisticsColumns)
+{
+  assert(graph);
+
+  if (!graph->hasMainFlow() || graph->hasMainFlowStatistics() != addStatisticsColumns)
+  {
+    calculate(graph, dominanceRelation, checkLocalDominance, localDominanceValue, addStatisticsColumns);
+    return;
+  }
+
+  if (!graph->isBuilt())
+    graph->build();
+
+  if (m_hasDominanceType && graph->hasDominanceModes())
+    graph->setDominanceType(m_dominanceType);
+
+  for (std::size_t t = 0; t < vertices.size(); ++t)
+    selectMainFlow(graph, vertices[t]);
+
+  if (m_rankCount > 0)
+  {
+    if (!graph->hasFlowRank())
+    {
+      graph->initFlowRank();
+
+      std::vector<int> buffer;
+
+      for (std::size_t v = 0; v < graph->getVertexCount(); ++v)
+        rankFlows(graph, (int)v, buffer);
+    }
+    else
+    {
+      std::vector<int> buffer;
+
+      for (std::size_t t = 0; t < vertices.size(); ++t)
+        rankFlows(graph, vertices[t], buffer);
+    }
+  }
+  else if (graph->hasFlowRank())
+  {
+    graph->clearFlowRank();
+  }
+
+  //the levels reached from the old roots are cleared
+  std::vector<int>& level = graph->getLevel();
+
+  std::fill(level.begin(), level.end(), -1);
+
+  MainFlowParameters params = MakeParameters(dominanceRelation, checkLocalDominance, localDominanceValue);
+
   //get roots
-  std::vector<te::graph::Vertex*> roots = getRoots(biGraph, checkLocalDominance);
+  std::vector<int> roots = getRoots(graph, params);
 
   //set level info into graph
-  int levelVertexAttrIdx = getVertexAttrIdx(biGraph, "level");
-  int domVertexAttrIdx = getVertexAttrIdx(biGraph, "dominance");
+  buildLevel(graph, roots, level);
 
-  buildLevel(biGraph, roots, levelVertexAttrIdx, domVertexAttrIdx);
+  if (graph->hasMainFlowStatistics())
+    buildStatistics(graph, params);
 }
-void te::qt::plugins::fiocruz::CalculateMainFlow::buildGraph(te::graph::BidirectionalGraph* biGraph, bool addStatisticsColumns)
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::updateWeights(FlowGraph* graph, const std::vector<EdgeWeightChange>& changes, DominanceType domType, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue)
 {
-  //add level attr to vertex
+  assert(graph);
+
+  //the changes are checked before any weight is written
+  int nEdge = (int)graph->getEdgeCount();
+
+  for (std::size_t t = 0; t < changes.size(); ++t)
+  {
+    if (changes[t].m_edge < 0 || changes[t].m_edge >= nEdge)
+      throw te::common::Exception(TE_TR("Invalid edge index in the flow weight changes."));
+  }
+
+  std::vector<double>& weight = graph->getWeight();
+
+  for (std::size_t t = 0; t < changes.size(); ++t)
+    weight[changes[t].m_edge] = changes[t].m_weight;
+
+  if (!graph->isBuilt())
+    graph->build();
+
+  //a dominance without the modes was associated from a layer, it does not depend on the weights
+  bool keepDominance = graph->hasDominance() && !graph->hasDominanceModes();
+
+  FlowDominance dominance;
+  dominance.setNumberOfThreads(m_numThreads);
+
+  if (!graph->hasMainFlow() || (!keepDominance && !graph->hasDominanceModes()))
   {
-    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("level", te::dt::INT32_TYPE);
-    p->setParent(0);
-    p->setId(0);
-    biGraph->addVertexProperty(p);
+    if (!keepDominance)
+      dominance.calculate(graph, domType);
+
+    calculate(graph, dominanceRelation, checkLocalDominance, localDominanceValue, graph->hasMainFlowStatistics());
+    return;
   }
 
-  if (addStatisticsColumns)
+  std::size_t nVertex = graph->getVertexCount();
+
+  const std::vector<int>& edgeFrom = graph->getEdgeFrom();
+  const std::vector<int>& edgeTo = graph->getEdgeTo();
+
+  //the dominance changes only on the endpoints and the main flow only on the origins
+  std::vector<unsigned char> mark(nVertex, 0);
+  std::vector<int> endpoints;
+  std::vector<int> origins;
+
+  for (std::size_t t = 0; t < changes.size(); ++t)
   {
-    // Adiciona o campo com a informacao de quem e o no superior imediato do no corrente
+    int vFrom = edgeFrom[changes[t].m_edge];
+    int vTo = edgeTo[changes[t].m_edge];
+
+    if (!(mark[vFrom] & 1))
     {
-      te::dt::SimpleProperty* p = new te::dt::SimpleProperty("destiny", te::dt::INT32_TYPE);
-      p->setParent(0);
-      p->setId(0);
-      biGraph->addVertexProperty(p);
+      mark[vFrom] |= 1;
+      endpoints.push_back(vFrom);
     }
 
-    // Adiciona o campo com a informacao de quantos nohs possuem na rede deste root
+    if (!(mark[vTo] & 1))
     {
-      te::dt::SimpleProperty* p = new te::dt::SimpleProperty("tree", te::dt::INT32_TYPE);
-      p->setParent(0);
-      p->setId(0);
-      biGraph->addVertexProperty(p);
+      mark[vTo] |= 1;
+      endpoints.push_back(vTo);
     }
 
-    // Adiciona o campo com a informacao de quantos filhos este noh possue
+    if (!(mark[vFrom] & 2))
     {
-      te::dt::SimpleProperty* p = new te::dt::SimpleProperty("input", te::dt::INT32_TYPE);
-      p->setParent(0);
-      p->setId(0);
-      biGraph->addVertexProperty(p);
+      mark[vFrom] |= 2;
+      origins.push_back(vFrom);
     }
   }
 
-  //add main flow attr to edge
+  if (!keepDominance)
   {
-    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("main_flow", te::dt::INT32_TYPE);
-    p->setParent(0);
-    p->setId(0);
-    biGraph->addEdgeProperty(p);
+    dominance.update(graph, domType, endpoints);
+
+    if (m_hasDominanceType)
+      graph->setDominanceType(m_dominanceType);
   }
 
-  int grapEdgeAttrSize = biGraph->getMetadata()->getEdgePropertySize();
+  for (std::size_t t = 0; t < origins.size(); ++t)
+    selectMainFlow(graph, origins[t]);
+
+  if (m_rankCount > 0)
+  {
+    std::vector<int> buffer;
+
+    if (!graph->hasFlowRank())
+    {
+      graph->initFlowRank();
+
+      for (std::size_t v = 0; v < nVertex; ++v)
+        rankFlows(graph, (int)v, buffer);
+    }
+    else
+    {
+      for (std::size_t t = 0; t < origins.size(); ++t)
+        rankFlows(graph, origins[t], buffer);
+    }
+  }
+  else if (graph->hasFlowRank())
+  {
+    graph->clearFlowRank();
+  }
 
+  //the root flag of a vertex depends on its own dominance and on the dominance of its main flow destiny
+  const std::vector<int>& inOffset = graph->getInOffsets();
+  const std::vector<int>& inEdges = graph->getInEdges();
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
 
-  //initialize main flow attr with 0 value
-  std::auto_ptr<te::graph::MemoryIterator> memIt(new te::graph::MemoryIterator(biGraph));
+  //with a kept dominance only the main flow of the origins changed
+  std::vector<int> vertices(keepDominance ? origins : endpoints);
 
-  te::graph::Edge* edge = memIt->getFirstEdge();
+  for (std::size_t t = 0; t < vertices.size(); ++t)
+    mark[vertices[t]] |= 4;
 
-  while (edge)
+  for (std::size_t t = 0; !keepDominance && t < endpoints.size(); ++t)
   {
-    edge->setAttributeVecSize(grapEdgeAttrSize);
+    int v = endpoints[t];
 
-    edge->addAttribute(grapEdgeAttrSize - 1, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(0));
+    for (int i = inOffset[v]; i < inOffset[v + 1]; ++i)
+    {
+      int vCur = edgeFrom[inEdges[i]];
+
+      if (!(mark[vCur] & 4))
+      {
+        mark[vCur] |= 4;
+        vertices.push_back(vCur);
+      }
+    }
+
+    for (int i = outOffset[v]; i < outOffset[v + 1]; ++i)
+    {
+      int vCur = edgeTo[outEdges[i]];
 
-    edge = memIt->getNextEdge();
+      if (!(mark[vCur] & 4))
+      {
+        mark[vCur] |= 4;
+        vertices.push_back(vCur);
+      }
+    }
   }
 
+  MainFlowParameters params = MakeParameters(dominanceRelation, checkLocalDominance, localDominanceValue);
+
+  updateLevels(graph, vertices, params);
+
+  if (graph->hasMainFlowStatistics())
+    buildStatistics(graph, params);
+}
+
+std::vector<te::qt::plugins::fiocruz::MainFlowSweepResult> te::qt::plugins::fiocruz::CalculateMainFlow::sweep(FlowGraph* graph, const std::vector<MainFlowParameters>& parameters, bool storeLevels)
+{
+  assert(graph);
 
-  //initialize vector attrs with -1 value
-  int vecAttrSize = biGraph->getMetadata()->getVertexPropertySize();
+  if (!graph->isBuilt())
+    graph->build();
 
-  te::graph::Vertex* vertex = memIt->getFirstVertex();
+  if (m_hasDominanceType && graph->hasDominanceModes())
+    graph->setDominanceType(m_dominanceType);
 
-  while (vertex)
+  if (!graph->hasDominance())
+    graph->initDominance();
+
+  std::size_t nVertex = graph->getVertexCount();
+
+  //the main flows do not depend on the parameters, they are selected once
+  std::vector<OutFlowSummary> summaries(nVertex);
+
+  ParallelFor(nVertex, m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
   {
-    vertex->setAttributeVecSize(vecAttrSize);
+    for (std::size_t v = begin; v < end; ++v)
+      summaries[v] = summarizeOutFlows(graph, (int)v);
+  });
+
+  //each parameter set is independent, the graph is only read
+  std::vector<MainFlowSweepResult> results(parameters.size());
 
-    vertex->addAttribute(vecAttrSize - 4, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(-1));
+  ParallelFor(parameters.size(), m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    std::vector<int> level;
 
-    if (addStatisticsColumns)
+    for (std::size_t p = begin; p < end; ++p)
     {
-      vertex->addAttribute(vecAttrSize - 3, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(-1));
-      vertex->addAttribute(vecAttrSize - 2, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(-1));
-      vertex->addAttribute(vecAttrSize - 1, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(-1));
+      MainFlowSweepResult& result = results[p];
+
+      result.m_parameters = parameters[p];
+
+      std::vector<int> roots;
+
+      for (std::size_t v = 0; v < nVertex; ++v)
+      {
+        if (checkRoot(graph, (int)v, summaries[v], parameters[p]))
+          roots.push_back((int)v);
+      }
+
+      level.assign(nVertex, -1);
+
+      buildLevel(graph, roots, level);
+
+      result.m_rootCount = roots.size();
+      result.m_unreachedCount = 0;
+
+      for (std::size_t v = 0; v < nVertex; ++v)
+      {
+        if (level[v] == -1)
+        {
+          ++result.m_unreachedCount;
+          continue;
+        }
+
+        if (level[v] >= (int)result.m_levelCount.size())
+          result.m_levelCount.resize(level[v] + 1, 0);
+
+        ++result.m_levelCount[level[v]];
+      }
+
+      if (storeLevels)
+        result.m_level = level;
     }
+  });
 
-    vertex = memIt->getNextVertex();
-  }
+  return results;
+}
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::buildHierarchy(FlowGraph* graph, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, FlowHierarchy& hierarchy)
+{
+  assert(graph);
+
+  if (!graph->isBuilt())
+    graph->build();
+
+  if (m_hasDominanceType && graph->hasDominanceModes())
+    graph->setDominanceType(m_dominanceType);
+
+  if (!graph->hasDominance())
+    graph->initDominance();
+
+  std::vector<int> superior;
+
+  getSuperiors(graph, MakeParameters(dominanceRelation, checkLocalDominance, localDominanceValue), superior);
+
+  hierarchy.build(superior);
+}
 
+void te::qt::plugins::fiocruz::CalculateMainFlow::setDominanceType(DominanceType type)
+{
+  m_dominanceType = type;
+  m_hasDominanceType = true;
+}
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::setRankCount(std::size_t k)
+{
+  m_rankCount = k;
+}
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::setNumberOfThreads(std::size_t numThreads)
+{
+  m_numThreads = numThreads;
+}
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::buildGraph(FlowGraph* graph, bool addStatisticsColumns)
+{
+  if (m_hasDominanceType && graph->hasDominanceModes())
+    graph->setDominanceType(m_dominanceType);
+
+  //the dominance is required to calculate the levels
+  if (!graph->hasDominance())
+    graph->initDominance();
+
+  //initialize main flow attr with 0 value and vertex attrs with -1 value
+  graph->initMainFlow(addStatisticsColumns);
 }
 
-int te::qt::plugins::fiocruz::CalculateMainFlow::getVertexAttrIdx(te::graph::AbstractGraph* graph, std::string attrName)
+te::qt::plugins::fiocruz::CalculateMainFlow::OutFlowSummary te::qt::plugins::fiocruz::CalculateMainFlow::summarizeOutFlows(FlowGraph* graph, int vertex)
 {
-  int idx = -1;
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
+  const std::vector<double>& weight = graph->getWeight();
 
-  for (int i = 0; i < graph->getVertexPropertySize(); ++i)
+  OutFlowSummary summary;
+  summary.m_mainEdge = -1;
+
+  double highWeight = -1.;
+
+  for (int t = outOffset[vertex]; t < outOffset[vertex + 1]; ++t)
   {
-    if (graph->getVertexProperty(i)->getName() == attrName)
+    int curEdge = outEdges[t];
+
+    if (weight[curEdge] > highWeight)
     {
-      idx = i;
-      break;
+      highWeight = weight[curEdge];
+      summary.m_mainEdge = curEdge;
     }
   }
 
-  return idx;
+  return summary;
+}
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::selectMainFlow(FlowGraph* graph, int vertex)
+{
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
+
+  std::vector<unsigned char>& mainFlow = graph->getMainFlow();
+
+  for (int t = outOffset[vertex]; t < outOffset[vertex + 1]; ++t)
+    mainFlow[outEdges[t]] = 0;
+
+  int edge = summarizeOutFlows(graph, vertex).m_mainEdge;
+
+  if (edge != -1)
+    mainFlow[edge] = 1;
 }
 
-int te::qt::plugins::fiocruz::CalculateMainFlow::getEdgeAttrIdx(te::graph::AbstractGraph* graph, std::string attrName)
+void te::qt::plugins::fiocruz::CalculateMainFlow::rankFlows(FlowGraph* graph, int vertex, std::vector<int>& buffer)
 {
-  int idx = -1;
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
+  const std::vector<double>& weight = graph->getWeight();
+
+  std::vector<int>& rank = graph->getFlowRank();
+  std::vector<double>& share = graph->getFlowShare();
+
+  buffer.assign(outEdges.begin() + outOffset[vertex], outEdges.begin() + outOffset[vertex + 1]);
+
+  double sum = 0.;
 
-  for (int i = 0; i < graph->getEdgePropertySize(); ++i)
+  for (std::size_t t = 0; t < buffer.size(); ++t)
   {
-    if (graph->getEdgeProperty(i)->getName() == attrName)
-    {
-      idx = i;
-      break;
-    }
+    rank[buffer[t]] = 0;
+    sum += weight[buffer[t]];
   }
 
-  return idx;
+  for (std::size_t t = 0; t < buffer.size(); ++t)
+    share[buffer[t]] = sum != 0. ? weight[buffer[t]] / sum : 0.;
+
+  //only the k heaviest edges are sorted, the same order used to select the main flow
+  std::size_t k = std::min(m_rankCount, buffer.size());
+
+  std::partial_sort(buffer.begin(), buffer.begin() + k, buffer.end(), [&weight](int a, int b)
+  {
+    if (weight[a] != weight[b])
+      return weight[a] > weight[b];
+
+    return a < b;
+  });
+
+  for (std::size_t t = 0; t < k; ++t)
+    rank[buffer[t]] = (int)t + 1;
 }
 
-int te::qt::plugins::fiocruz::CalculateMainFlow::getEdgeWeightAttrValue(te::graph::Edge* e, int attrIdx)
+bool te::qt::plugins::fiocruz::CalculateMainFlow::checkRoot(FlowGraph* graph, int vertex, const OutFlowSummary& summary, const MainFlowParameters& params)
 {
-  std::string weightStr = e->getAttributes()[attrIdx]->toString();
+  if (summary.m_mainEdge == -1)
+    return false;
+
+  int vTo = graph->getEdgeTo()[summary.m_mainEdge];
 
-  return atoi(weightStr.c_str());
+  //a local main flow is verified only if requested
+  if (vTo == vertex && !params.m_checkLocalDominance)
+    return false;
+
+  const std::vector<double>& dominance = graph->getDominance();
+
+  //if main flow is from a vertex with dominance value higher than to destiny, than this vertex is root
+  return dominance[vertex] >= dominance[vTo];
 }
 
-int te::qt::plugins::fiocruz::CalculateMainFlow::getEdgeMainFlowAttrValue(te::graph::Edge* e, int attrIdx)
+std::vector<int> te::qt::plugins::fiocruz::CalculateMainFlow::getRoots(FlowGraph* graph, const MainFlowParameters& params)
 {
-  std::string mainFlowStr = e->getAttributes()[attrIdx]->toString();
+  std::vector<unsigned char> isRoot(graph->getVertexCount(), 0);
 
-  return atoi(mainFlowStr.c_str());
-}
+  ParallelFor(graph->getVertexCount(), m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    for (std::size_t v = begin; v < end; ++v)
+      isRoot[v] = checkRoot(graph, (int)v, summarizeOutFlows(graph, (int)v), params) ? 1 : 0;
+  });
+
+  std::vector<int> roots;
+
+  for (std::size_t v = 0; v < isRoot.size(); ++v)
+  {
+    if (isRoot[v])
+      roots.push_back((int)v);
+  }
 
+  return roots;
+}
 
-te::graph::Edge* te::qt::plugins::fiocruz::CalculateMainFlow::getHighWeightEdge(te::graph::BidirectionalGraph* biGraph, std::vector<te::graph::Edge*> edgeVec)
+void te::qt::plugins::fiocruz::CalculateMainFlow::buildLevel(FlowGraph* graph, const std::vector<int>& roots, std::vector<int>& level)
 {
-  te::graph::Edge* edge = 0;
+  std::vector<unsigned char> visited(graph->getVertexCount(), 0);
+
+  //the queue keeps every visited vertex, head is the next one to be expanded
+  std::vector<int> queue;
+  queue.reserve(graph->getVertexCount());
+
+  for (std::size_t t = 0; t < roots.size(); ++t)
+  {
+    int root = roots[t];
 
-  int weightAttrIdx = getEdgeAttrIdx(biGraph, "weight");
+    if (visited[root])
+      continue;
 
-  int highWeight = -1;
+    visited[root] = 1;
+    level[root] = 0;
+
+    queue.push_back(root);
+  }
 
-  for (std::size_t t = 0; t < edgeVec.size(); ++t)
+  std::vector<int> dominatedNodes;
+
+  for (std::size_t head = 0; head < queue.size(); ++head)
   {
-    te::graph::Edge* curEdge = edgeVec[t];
+    int vertex = queue[head];
 
-    int curWeight = getEdgeWeightAttrValue(curEdge, weightAttrIdx);
+    getDominatedNodes(graph, vertex, dominatedNodes);
 
-    if (curWeight > highWeight)
+    for (std::size_t t = 0; t < dominatedNodes.size(); ++t)
     {
-      highWeight = curWeight;
-      edge = curEdge;
+      int vCur = dominatedNodes[t];
+
+      if (visited[vCur])
+        continue;
+
+      visited[vCur] = 1;
+      level[vCur] = level[vertex] + 1;
+
+      queue.push_back(vCur);
     }
   }
-
-  return edge;
 }
 
-std::vector<te::graph::Vertex*> te::qt::plugins::fiocruz::CalculateMainFlow::getRoots(te::graph::AbstractGraph* graph, bool checkLocalDominance)
+void te::qt::plugins::fiocruz::CalculateMainFlow::updateLevels(FlowGraph* graph, const std::vector<int>& vertices, const MainFlowParameters& params)
 {
-  std::vector<te::graph::Vertex*> roots;
+  std::size_t nVertex = graph->getVertexCount();
+
+  std::vector<int>& level = graph->getLevel();
+
+  //the root flag changes only on the given vertices, the other roots keep the level 0
+  std::vector<signed char> root(nVertex, -1);
+
+  for (std::size_t t = 0; t < vertices.size(); ++t)
+  {
+    int v = vertices[t];
+
+    root[v] = checkRoot(graph, v, summarizeOutFlows(graph, v), params) ? 1 : 0;
+  }
+
+  typedef std::pair<int, int> LevelItem;
+  typedef std::priority_queue<LevelItem, std::vector<LevelItem>, std::greater<LevelItem> > LevelQueue;
 
-  int mainFlowIdx = getEdgeAttrIdx(graph, "main_flow");
-  int domVertexAttrIdx = getVertexAttrIdx(graph, "dominance");
+  //0: untouched, 1: queued, 2: lost its support
+  std::vector<unsigned char> state(nVertex, 0);
+  std::vector<int> cleared;
+  std::vector<int> domVec;
 
-  //iterate over the graph
-  std::auto_ptr<te::graph::MemoryIterator> memIt(new te::graph::MemoryIterator(graph));
+  LevelQueue queue;
 
-  te::graph::Edge* edge = memIt->getFirstEdge();
+  for (std::size_t t = 0; t < vertices.size(); ++t)
+  {
+    int v = vertices[t];
+
+    if (level[v] != -1 && root[v] != 1)
+    {
+      state[v] = 1;
+      queue.push(LevelItem(level[v], v));
+    }
+  }
 
-  while (edge)
+  //a level is kept if a dominant neighbor is one level above, the lower levels are decided first
+  while (!queue.empty())
   {
-    int mainFlowValue = getEdgeMainFlowAttrValue(edge, mainFlowIdx);
+    int curLevel = queue.top().first;
+    int vertex = queue.top().second;
+
+    queue.pop();
+
+    if (root[vertex] == 1 || (root[vertex] == -1 && curLevel == 0))
+      continue;
+
+    getDominantNodes(graph, vertex, domVec);
+
+    bool supported = false;
+
+    for (std::size_t t = 0; t < domVec.size() && !supported; ++t)
+    {
+      int vCur = domVec[t];
+
+      supported = state[vCur] != 2 && level[vCur] != -1 && level[vCur] == curLevel - 1;
+    }
+
+    if (supported)
+      continue;
+
+    state[vertex] = 2;
+    cleared.push_back(vertex);
+
+    getDominatedNodes(graph, vertex, domVec);
 
-    //verify only main edges
-    if (mainFlowValue == 1)
+    for (std::size_t t = 0; t < domVec.size(); ++t)
     {
-      te::graph::Vertex* vFrom = graph->getVertex(edge->getIdFrom());
-      te::graph::Vertex* vTo = graph->getVertex(edge->getIdTo());
+      int vCur = domVec[t];
 
-      if (vFrom && vTo)
+      if (state[vCur] == 0 && level[vCur] == curLevel + 1)
       {
-        bool check = false;
+        state[vCur] = 1;
+        queue.push(LevelItem(level[vCur], vCur));
+      }
+    }
+  }
 
-        if (vFrom->getId() == vTo->getId() && checkLocalDominance)
-          check = true;
-        else if (vFrom->getId() != vTo->getId())
-          check = true;
+  for (std::size_t t = 0; t < cleared.size(); ++t)
+    level[cleared[t]] = -1;
 
-        if (check)
-        {
-          te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>* vDomDataFrom = dynamic_cast<te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>*>(vFrom->getAttributes()[domVertexAttrIdx]);
-          double vDomFromValue = vDomDataFrom->getValue();
+  //search again from the neighbors of the cleared and the given vertices
+  std::vector<int> seeds(vertices);
+  seeds.insert(seeds.end(), cleared.begin(), cleared.end());
 
-          te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>* vDomDataTo = dynamic_cast<te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>*>(vTo->getAttributes()[domVertexAttrIdx]);
-          double vDomToValue = vDomDataTo->getValue();
+  for (std::size_t t = 0; t < seeds.size(); ++t)
+  {
+    int v = seeds[t];
 
-          //if main flow is from a vertex with dominance value higher than to destiny, than this vertex is root
-          if (vDomFromValue >= vDomToValue)
-          {
-            roots.push_back(vFrom);
-          }
-        }
+    int newLevel = -1;
+
+    if (root[v] == 1)
+    {
+      newLevel = 0;
+    }
+    else
+    {
+      getDominantNodes(graph, v, domVec);
+
+      for (std::size_t i = 0; i < domVec.size(); ++i)
+      {
+        int vCur = domVec[i];
+
+        if (level[vCur] != -1 && (newLevel == -1 || level[vCur] + 1 < newLevel))
+          newLevel = level[vCur] + 1;
       }
     }
 
-    edge = memIt->getNextEdge();
+    if (newLevel != -1 && (level[v] == -1 || newLevel < level[v]))
+    {
+      level[v] = newLevel;
+      queue.push(LevelItem(newLevel, v));
+    }
   }
 
-  return roots;
+  while (!queue.empty())
+  {
+    int curLevel = queue.top().first;
+    int vertex = queue.top().second;
+
+    queue.pop();
+
+    if (curLevel != level[vertex])
+      continue;
+
+    getDominatedNodes(graph, vertex, domVec);
+
+    for (std::size_t t = 0; t < domVec.size(); ++t)
+    {
+      int vCur = domVec[t];
+
+      if (level[vCur] == -1 || level[vCur] > curLevel + 1)
+      {
+        level[vCur] = curLevel + 1;
+        queue.push(LevelItem(curLevel + 1, vCur));
+      }
+    }
+  }
 }
 
-void te::qt::plugins::fiocruz::CalculateMainFlow::buildLevel(te::graph::BidirectionalGraph* graph, std::vector<te::graph::Vertex*> roots, int levelVertexAttrIdx, int domVertexAttrIdx)
+void te::qt::plugins::fiocruz::CalculateMainFlow::buildStatistics(FlowGraph* graph, const MainFlowParameters& params)
 {
-  for (std::size_t t = 0; t < roots.size(); ++t)
+  std::size_t nVertex = graph->getVertexCount();
+
+  const std::vector<int>& vertexIds = graph->getVertexIds();
+
+  std::vector<int>& destiny = graph->getDestiny();
+  std::vector<int>& tree = graph->getTree();
+  std::vector<int>& input = graph->getInput();
+
+  std::vector<int> superior;
+
+  getSuperiors(graph, params, superior);
+
+  //the dominance grows along the superior links, so they have no cycles
+  DisjointSet trees(nVertex);
+
+  for (std::size_t v = 0; v < nVertex; ++v)
+  {
+    destiny[v] = -1;
+    tree[v] = -1;
+    input[v] = 0;
+  }
+
+  for (std::size_t v = 0; v < nVertex; ++v)
   {
-    int level = 0;
+    int s = superior[v];
 
-    buildLevel(graph, roots[t], level, levelVertexAttrIdx, domVertexAttrIdx);
+    if (s == -1)
+      continue;
+
+    destiny[v] = vertexIds[s];
+    ++input[s];
+
+    trees.unite((int)v, s);
+  }
+
+  for (std::size_t v = 0; v < nVertex; ++v)
+  {
+    if (superior[v] == -1)
+      tree[v] = trees.getSize((int)v);
   }
 }
 
-void te::qt::plugins::fiocruz::CalculateMainFlow::buildLevel(te::graph::BidirectionalGraph* graph, te::graph::Vertex* vertex, int level, int levelVertexAttrIdx, int domVertexAttrIdx)
+void te::qt::plugins::fiocruz::CalculateMainFlow::getSuperiors(FlowGraph* graph, const MainFlowParameters& params, std::vector<int>& superior)
 {
-  vertex->addAttribute(levelVertexAttrIdx, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(level));
+  std::size_t nVertex = graph->getVertexCount();
+
+  const std::vector<int>& edgeTo = graph->getEdgeTo();
+
+  //superior of each vertex, the destiny of its main flow if the vertex is not a root
+  superior.assign(nVertex, -1);
+
+  ParallelFor(nVertex, m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    for (std::size_t v = begin; v < end; ++v)
+    {
+      OutFlowSummary summary = summarizeOutFlows(graph, (int)v);
 
-  std::vector<te::graph::Vertex*> dominatedNodes = getDominatedNodes(graph, vertex, domVertexAttrIdx);
+      if (summary.m_mainEdge == -1)
+        continue;
 
-  for (std::size_t t = 0; t < dominatedNodes.size(); ++t)
-    buildLevel(graph, dominatedNodes[t], level + 1, levelVertexAttrIdx, domVertexAttrIdx);
+      int vTo = edgeTo[summary.m_mainEdge];
+
+      if (vTo != (int)v && !checkRoot(graph, (int)v, summary, params))
+        superior[v] = vTo;
+    }
+  });
 }
 
-std::vector<te::graph::Vertex*> te::qt::plugins::fiocruz::CalculateMainFlow::getDominatedNodes(te::graph::BidirectionalGraph* graph, te::graph::Vertex* vertex, int domVertexAttrIdx)
+void te::qt::plugins::fiocruz::CalculateMainFlow::getDominatedNodes(FlowGraph* graph, int vertex, std::vector<int>& domVec)
 {
-  std::vector<te::graph::Vertex*> domVec;
+  domVec.clear();
 
-  te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>* vDomData = dynamic_cast< te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>* >(vertex->getAttributes()[domVertexAttrIdx]);
+  const std::vector<double>& dominance = graph->getDominance();
+
+  double vDomValue = dominance[vertex];
+
+  //vertex neighborhood: origin of the input edges and destiny of the output edges
+  const std::vector<int>& inOffset = graph->getInOffsets();
+  const std::vector<int>& inEdges = graph->getInEdges();
+  const std::vector<int>& edgeFrom = graph->getEdgeFrom();
+
+  for (int t = inOffset[vertex]; t < inOffset[vertex + 1]; ++t)
+  {
+    int vCur = edgeFrom[inEdges[t]];
 
-  double vDomValue = vDomData->getValue();
+    if (vDomValue > dominance[vCur])
+      domVec.push_back(vCur);
+  }
 
-  std::vector<te::graph::Vertex*> vNeigh = graph->getVertexNeighborhood(vertex->getId());
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
+  const std::vector<int>& edgeTo = graph->getEdgeTo();
 
-  for (std::size_t t = 0; t < vNeigh.size(); ++t)
+  for (int t = outOffset[vertex]; t < outOffset[vertex + 1]; ++t)
   {
-    te::graph::Vertex* vCur = vNeigh[t];
+    int vCur = edgeTo[outEdges[t]];
+
+    if (vDomValue > dominance[vCur])
+      domVec.push_back(vCur);
+  }
+}
+
+void te::qt::plugins::fiocruz::CalculateMainFlow::getDominantNodes(FlowGraph* graph, int vertex, std::vector<int>& domVec)
+{
+  domVec.clear();
 
-    te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>* vCurDomData = dynamic_cast< te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>* >(vCur->getAttributes()[domVertexAttrIdx]);
+  const std::vector<double>& dominance = graph->getDominance();
 
-    double vCurDomValue = vCurDomData->getValue();
+  double vDomValue = dominance[vertex];
 
-    if (vDomValue > vCurDomValue)
+  const std::vector<int>& inOffset = graph->getInOffsets();
+  const std::vector<int>& inEdges = graph->getInEdges();
+  const std::vector<int>& edgeFrom = graph->getEdgeFrom();
+
+  for (int t = inOffset[vertex]; t < inOffset[vertex + 1]; ++t)
+  {
+    int vCur = edgeFrom[inEdges[t]];
+
+    if (dominance[vCur] > vDomValue)
       domVec.push_back(vCur);
   }
 
-  return domVec;
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
+  const std::vector<int>& edgeTo = graph->getEdgeTo();
+
+  for (int t = outOffset[vertex]; t < outOffset[vertex + 1]; ++t)
+  {
+    int vCur = edgeTo[outEdges[t]];
+
+    if (dominance[vCur] > vDomValue)
+      domVec.push_back(vCur);
+  }
 }
@@ -26,15 +26,13 @@ TerraLib Team at <terralib-team@terralib.org>.
 #ifndef __FIOCRUZ_INTERNAL_FLOW_CALCULATEMAINFLOW_H
 #define __FIOCRUZ_INTERNAL_FLOW_CALCULATEMAINFLOW_H
 
-// TerraLib
-#include <terralib/graph/core/AbstractGraph.h>
-#include <terralib/graph/core/Vertex.h>
-#include <terralib/graph/graphs/BidirectionalGraph.h>
-
 #include "../Config.h"
+#include "core/FlowGraph.h"
+#include "core/FlowHierarchy.h"
 
 // STL
 #include <memory>
+#include <vector>
 
 namespace te
 {
@@ -44,6 +42,46 @@ namespace te
     {
       namespace fiocruz
       {
+        /*!
+        \struct MainFlowParameters
+
+        \brief Parameters that define which vertices are roots of the main flow forest.
+
+        The root rule uses only the local verification flag, the dominance relation and
+        local dominance values are kept for the callers of calculate and are not applied.
+        */
+        struct MainFlowParameters
+        {
+          double m_dominanceRelation;     //!< Dominance relation (%) of the dialog, not applied by the root rule
+          bool m_checkLocalDominance;     //!< Verify the local flow (flows with the same origin and destiny)
+          double m_localDominanceValue;   //!< Local dominance value (%) of the dialog, not applied by the root rule
+        };
+
+        /*!
+        \struct EdgeWeightChange
+
+        \brief New weight of an existing edge, used by the incremental main flow update.
+        */
+        struct EdgeWeightChange
+        {
+          int m_edge;       //!< Dense index of the edge
+          double m_weight;  //!< New flow value
+        };
+
+        /*!
+        \struct MainFlowSweepResult
+
+        \brief Summary of the main flow forest of one parameter set of a sweep.
+        */
+        struct MainFlowSweepResult
+        {
+          MainFlowParameters m_parameters;  //!< Parameter set used
+          std::size_t m_rootCount;          //!< Number of roots
+          std::size_t m_unreachedCount;     //!< Number of vertices not reached from a root (level -1)
+          std::vector<int> m_levelCount;    //!< Number of vertices of each level
+          std::vector<int> m_level;         //!< Level of each vertex, only filled if requested
+        };
+
         /*!
         \class CalculateMainFlow
 
@@ -60,29 +98,181 @@ namespace te
 
           public:
 
-            void calculate(te::graph::BidirectionalGraph* biGraph, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, bool addStatisticsColumns);
+            /*!
+            \brief Selects the main flow of each vertex and builds the levels from the roots.
+
+            A vertex is a root if its main flow goes to a vertex with a lower or equal
+            dominance. A local main flow (same origin and destiny) makes the vertex a root
+            only when checkLocalDominance is set. The dominance relation and local dominance
+            values are not used here, see sweep.
+            */
+            void calculate(FlowGraph* graph, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, bool addStatisticsColumns);
+
+            /*!
+            \brief Defines the dominance type used to build the levels.
+
+            It requires the dominance of all types (see FlowDominance::calculate), so input
+            and output dominance can be compared without calculating the dominance again.
+            If it is not defined, the current graph dominance is used.
+            */
+            void setDominanceType(DominanceType type);
+
+            /*!
+            \brief Defines how many of the heaviest output edges of each vertex are ranked.
+
+            With k > 0 the flow_rank column gets 1..k for the k heaviest output edges of each
+            vertex (1 is the main flow, ties keep the lowest edge index) and 0 for the other
+            edges, and the flow_share column gets the edge weight divided by the sum of the
+            output weights of its origin. The default (0) does not create these columns and
+            removes them from a graph that has them, so they never describe older weights.
+            */
+            void setRankCount(std::size_t k);
+
+            /*!
+            \brief Defines the number of threads used to select the main flows and the roots.
+
+            \param numThreads   Number of worker threads, 1 uses the calling thread (default) and 0 uses one thread per core
+            */
+            void setNumberOfThreads(std::size_t numThreads);
+
+            /*!
+            \brief Recalculates the main flow after FlowGraphImport::appendGraph.
+
+            The main flow is selected again only for the given vertices, the only ones whose
+            output edges may have changed. The roots and the levels depend on the whole
+            forest, so they are rebuilt for all vertices. If the graph has no main flow
+            column, calculate is used.
+
+            \param vertices   Dense indexes of the vertices with new or changed edges
+            */
+            void update(FlowGraph* graph, const std::vector<int>& vertices, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, bool addStatisticsColumns);
+
+            /*!
+            \brief Changes the weight of some edges and updates the dominance and the main flow incrementally.
+
+            Only the dominance of the edge endpoints is calculated again (see FlowDominance::update),
+            the main flow is selected again only for the origins of the changed edges and the
+            root flags are checked again only for the endpoints and their neighbors. The levels
+            that lost their support are cleared and the affected subtrees are searched again
+            from their neighbors, so the result is the same of a full calculate. The destiny,
+            tree and input columns, if present, are rebuilt. The import statistics columns
+            (sum_in, sum_out, ...) are not changed.
+
+            A dominance associated from a layer (no dominance of all types) does not depend on
+            the weights, so it is kept and only the main flow and the levels are updated.
+            Otherwise, if the graph has no main flow or no dominance of all types, the dominance
+            and the main flow are fully calculated. An edge index out of range throws before
+            any weight is changed.
+
+            \param changes   New weight of the changed edges
+            \param domType   Dominance type used by FlowDominance
+            */
+            void updateWeights(FlowGraph* graph, const std::vector<EdgeWeightChange>& changes, DominanceType domType, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue);
+
+            /*!
+            \brief Calculates the roots and levels for several parameter sets in one run.
+
+            Each parameter set uses the same root rule of calculate (see checkRoot), so the
+            levels of a result are the levels calculate would write with those parameters.
+
+            The main flows do not depend on the parameters, so they are selected once and
+            the parameter sets are evaluated in parallel. Like calculate, the dominance type
+            defined by setDominanceType is selected in the graph and a zero dominance column
+            is created if the graph has none. The main flow, level and statistics columns
+            are not changed.
+
+            \param parameters    Parameter sets to be evaluated
+            \param storeLevels   Flag used to keep the level of each vertex in the results
+
+            \return One result for each parameter set, in the same order.
+            */
+            std::vector<MainFlowSweepResult> sweep(FlowGraph* graph, const std::vector<MainFlowParameters>& parameters, bool storeLevels);
+
+            /*!
+            \brief Builds the hierarchy index of the main flow forest (see buildStatistics for the superior links).
+
+            The graph columns are not changed, the dominance of the graph (or the one defined
+            by setDominanceType) is used.
+            */
+            void buildHierarchy(FlowGraph* graph, const double& dominanceRelation, const bool& checkLocalDominance, const double& localDominanceValue, FlowHierarchy& hierarchy);
 
           protected:
 
-            void buildGraph(te::graph::BidirectionalGraph* biGraph, bool addStatisticsColumns);
+            /*!
+            \struct OutFlowSummary
+
+            \brief Main flow of a vertex, it does not depend on the parameters.
+            */
+            struct OutFlowSummary
+            {
+              int m_mainEdge;         //!< Output edge with the highest weight or -1
+            };
+
+            void buildGraph(FlowGraph* graph, bool addStatisticsColumns);
+
+            /*! \brief Scans the output edges of a vertex once, the main edge is the one with the highest weight (on ties the lowest edge index). */
+            OutFlowSummary summarizeOutFlows(FlowGraph* graph, int vertex);
+
+            /*! \brief Clears the main flow of the output edges of a vertex and marks the one with the highest weight. */
+            void selectMainFlow(FlowGraph* graph, int vertex);
+
+            /*! \brief Sets the rank and share of the output edges of a vertex, only the m_rankCount heaviest edges are sorted. */
+            void rankFlows(FlowGraph* graph, int vertex, std::vector<int>& buffer);
 
-            int getVertexAttrIdx(te::graph::AbstractGraph* graph, std::string attrName);
+            /*! \brief Returns true if a vertex is a root, only the local verification flag of the parameters is used (see calculate). */
+            bool checkRoot(FlowGraph* graph, int vertex, const OutFlowSummary& summary, const MainFlowParameters& params);
 
-            int getEdgeAttrIdx(te::graph::AbstractGraph* graph, std::string attrName);
+            /*! \brief Returns the vertices that are roots, in vertex order. */
+            std::vector<int> getRoots(FlowGraph* graph, const MainFlowParameters& params);
 
-            int getEdgeWeightAttrValue(te::graph::Edge* e, int attrIdx);
+            /*!
+            \brief Sets the level of the vertices reached from the roots, using a breadth first search.
 
-            int getEdgeMainFlowAttrValue(te::graph::Edge* e, int attrIdx);
+            The roots get level 0 and each dominated vertex gets the level of the first
+            vertex that reaches it plus one, so it is the shortest distance to a root.
+            Each vertex is visited once, so the cost is linear on the graph size. The level
+            vector must be filled with -1, the graph is only read.
+            */
+            void buildLevel(FlowGraph* graph, const std::vector<int>& roots, std::vector<int>& level);
 
-            te::graph::Edge* getHighWeightEdge(te::graph::BidirectionalGraph* biGraph, std::vector<te::graph::Edge*> edgeVec);
+            /*!
+            \brief Fills the destiny, tree and input columns from the main flow forest.
 
-            std::vector<te::graph::Vertex*> getRoots(te::graph::AbstractGraph* graph, bool checkLocalDominance);
+            The superior of a vertex is the destiny of its main flow when the vertex is not
+            a root (the destiny has a higher dominance), these links form a forest. destiny
+            is the external id of the superior (-1 for the top vertices), input is the number
+            of vertices that have the vertex as superior and tree is the number of vertices of
+            the tree of a top vertex (-1 for the other vertices). The tree sizes are counted
+            with a union-find, so the cost is near linear.
+            */
+            void buildStatistics(FlowGraph* graph, const MainFlowParameters& params);
 
-            void buildLevel(te::graph::BidirectionalGraph* graph, std::vector<te::graph::Vertex*> roots, int levelVertexAttrIdx, int domVertexAttrIdx);
+            /*! \brief Fills superior with the destiny of the main flow of each vertex that is not a root, -1 for the other vertices. */
+            void getSuperiors(FlowGraph* graph, const MainFlowParameters& params, std::vector<int>& superior);
 
-            void buildLevel(te::graph::BidirectionalGraph* graph, te::graph::Vertex* vertex, int level, int levelVertexAttrIdx, int domVertexAttrIdx);
+            /*!
+            \brief Updates the levels after the root flags or the dominance of some vertices changed.
+
+            The vertices whose level has no more a neighbor with a higher dominance one level
+            above are cleared, in increasing level order, then the cleared and the given
+            vertices are searched again from their neighbors (shortest level first).
+
+            \param vertices   Vertices whose root flag or dominated neighbors may have changed
+            */
+            void updateLevels(FlowGraph* graph, const std::vector<int>& vertices, const MainFlowParameters& params);
+
+            /*! \brief Fills domVec with the neighbors of a vertex that have a lower dominance. */
+            void getDominatedNodes(FlowGraph* graph, int vertex, std::vector<int>& domVec);
+
+            /*! \brief Fills domVec with the neighbors of a vertex that have a higher dominance. */
+            void getDominantNodes(FlowGraph* graph, int vertex, std::vector<int>& domVec);
+
+          protected:
 
-            std::vector<te::graph::Vertex*> getDominatedNodes(te::graph::BidirectionalGraph* graph, te::graph::Vertex* vertex, int domVertexAttrIdx);
+            DominanceType m_dominanceType;    //!< Dominance type used to build the levels
+            bool m_hasDominanceType;          //!< The dominance type was defined
+            std::size_t m_numThreads;         //!< Number of threads used to select the main flows and the roots
+            std::size_t m_rankCount;          //!< Number of ranked output edges per vertex, 0 disables the ranking
 
         };
       }   // end namespace fiocruz
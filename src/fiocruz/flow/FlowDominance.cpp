@@ -25,21 +25,17 @@ TerraLib Team at <terralib-team@terralib.org>.
 
 
 #include "FlowDominance.h"
+#include "core/IdDictionary.h"
+#include "core/ParallelUtils.h"
 
-//terralib
-#include <terralib/datatype/SimpleData.h>
-#include <terralib/datatype/SimpleProperty.h>
-#include <terralib/graph/core/AbstractGraph.h>
-#include <terralib/graph/core/AbstractGraphFactory.h>
-#include <terralib/graph/core/GraphMetadata.h>
-#include <terralib/graph/core/Edge.h>
-#include <terralib/graph/core/Vertex.h>
-#include <terralib/graph/graphs/BidirectionalGraph.h>
-#include <terralib/graph/iterator/MemoryIterator.h>
+// STL
+#include <algorithm>
 
 
 te::qt::plugins::fiocruz::FlowDominance::FlowDominance()
 {
+  m_numThreads = 1;
+  m_batchSize = 65536;
 }
 
 te::qt::plugins::fiocruz::FlowDominance::~FlowDominance()
@@ -47,128 +43,272 @@ te::qt::plugins::fiocruz::FlowDominance::~FlowDominance()
 
 }
 
-void te::qt::plugins::fiocruz::FlowDominance::associate(te::graph::AbstractGraph* graph, te::da::DataSourcePtr ds, std::string dataSetName, int idIdx, int domIdx)
+te::qt::plugins::fiocruz::DominanceJoinReport te::qt::plugins::fiocruz::FlowDominance::associate(FlowGraph* graph, te::da::DataSourcePtr ds, std::string dataSetName, int idIdx, int domIdx)
 {
   assert(graph);
 
-  int domAttrIdx = addDominanceAttr(graph);
+  graph->initDominance();
 
-  int graphVecAttrSize = graph->getMetadata()->getVertexPropertySize();
+  DominanceJoinReport report;
+  report.m_rowCount = 0;
+  report.m_matchedVertexCount = 0;
 
   //get dataset
   std::auto_ptr<te::da::DataSet> dataSet = ds->getDataSet(dataSetName);
-  dataSet->moveBeforeFirst();
 
-  while (dataSet->moveNext())
-  {
-    std::string curIdStr = dataSet->getAsString(idIdx);
-    std::string curDomStr = dataSet->getAsString(domIdx);
+  ColumnReader idReader(dataSet.get(), (std::size_t)idIdx);
+  ColumnReader domReader(dataSet.get(), (std::size_t)domIdx);
 
-    //get vertex
-    te::graph::Vertex* v = graph->getVertex(atoi(curIdStr.c_str()));
-
-    if (v)
-    {
-      //set dominance value
-      v->setAttributeVecSize(graphVecAttrSize);
+  //the index is built on the smaller side, the graph vertices are already indexed
+  if (dataSet->size() < graph->getVertexCount())
+    joinByRowIndex(graph, dataSet.get(), idReader, domReader, report);
+  else
+    joinByGraphIndex(graph, dataSet.get(), idReader, domReader, report);
 
-      v->addAttribute(graphVecAttrSize - 1, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(atol(curDomStr.c_str())));
-    }
-  }
+  return report;
 }
 
-void te::qt::plugins::fiocruz::FlowDominance::calculate(te::graph::AbstractGraph* graph, DominanceType domType)
+void te::qt::plugins::fiocruz::FlowDominance::calculate(FlowGraph* graph, DominanceType domType)
 {
   assert(graph);
 
-  int domAttrIdx = addDominanceAttr(graph);
+  graph->initDominanceModes();
 
-  int graphVecAttrSize = graph->getMetadata()->getVertexPropertySize();
+  std::size_t nVertex = graph->getVertexCount();
+  std::size_t nEdge = graph->getEdgeCount();
 
-  te::graph::BidirectionalGraph* biGraph = dynamic_cast<te::graph::BidirectionalGraph*>(graph);
+  const std::vector<int>& from = graph->getEdgeFrom();
+  const std::vector<int>& to = graph->getEdgeTo();
+  const std::vector<double>& weight = graph->getWeight();
 
-  if (!biGraph)
-    return;
+  std::vector<double>& domIn = graph->getDominance(DOMINANCE_INPUTFLOW);
+  std::vector<double>& domOut = graph->getDominance(DOMINANCE_OUTPUTFLOW);
 
-  //get iterator
-  std::auto_ptr<te::graph::MemoryIterator> iterator(new te::graph::MemoryIterator(biGraph));
+  //each thread sums a range of edges into its own input / output columns, the first thread uses the graph columns
+  std::size_t numThreads = std::min(GetThreadCount(m_numThreads), std::max(nEdge, (std::size_t)1));
 
-  te::graph::Vertex* v = iterator->getFirstVertex();
+  std::vector<std::vector<double> > partialIn(numThreads - 1);
+  std::vector<std::vector<double> > partialOut(numThreads - 1);
 
-  while (v)
+  ParallelFor(nEdge, numThreads, [&](std::size_t begin, std::size_t end, std::size_t t)
   {
-    //get vertex neighbour
-    std::vector<te::graph::Edge*> edges;
+    if (t > 0)
+    {
+      partialIn[t - 1].assign(nVertex, 0.);
+      partialOut[t - 1].assign(nVertex, 0.);
+    }
 
-    if (domType == te::qt::plugins::fiocruz::DOMINANCE_INPUTFLOW)
-      edges = biGraph->getInEdges(v->getId());
-    else if (domType == te::qt::plugins::fiocruz::DOMINANCE_OUTPUTFLOW)
-      edges = biGraph->getOutEdges(v->getId());
+    double* in = t > 0 ? partialIn[t - 1].data() : domIn.data();
+    double* out = t > 0 ? partialOut[t - 1].data() : domOut.data();
 
-    //calculate dominance
-    double dominanceValue = 0.;
+    for (std::size_t e = begin; e < end; ++e)
+    {
+      in[to[e]] += weight[e];
+      out[from[e]] += weight[e];
+    }
+  });
 
-    for (std::size_t t = 0; t < edges.size(); ++t)
+  //reduce the partial columns and derive the net and total dominance
+  ParallelFor(nVertex, m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    for (std::size_t t = 0; t < partialIn.size(); ++t)
     {
-      dominanceValue += getEdgeWeightAttrValue(graph, edges[t]);
+      for (std::size_t v = begin; v < end; ++v)
+      {
+        domIn[v] += partialIn[t][v];
+        domOut[v] += partialOut[t][v];
+      }
     }
 
-    //set dominance value
-    v->setAttributeVecSize(graphVecAttrSize);
-    v->addAttribute(graphVecAttrSize - 1, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(dominanceValue));
+    combine(graph, begin, end);
+  });
 
-    v = iterator->getNextVertex();
-  }
+  graph->setDominanceType(domType);
 }
 
-int te::qt::plugins::fiocruz::FlowDominance::addDominanceAttr(te::graph::AbstractGraph* graph)
+void te::qt::plugins::fiocruz::FlowDominance::update(FlowGraph* graph, DominanceType domType, const std::vector<int>& vertices)
 {
-  //create property
-  std::string attrName = "dominance";
-  te::dt::SimpleProperty* p = new te::dt::SimpleProperty(attrName, te::dt::DOUBLE_TYPE);
-  p->setParent(0);
-  p->setId(0);
+  assert(graph);
 
-  graph->addVertexProperty(p);
+  if (!graph->hasDominanceModes())
+  {
+    calculate(graph, domType);
+    return;
+  }
 
-  // verify what the index of the new property
-  int idx = 0;
+  const std::vector<int>& inOffset = graph->getInOffsets();
+  const std::vector<int>& inEdges = graph->getInEdges();
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
+  const std::vector<double>& weight = graph->getWeight();
 
-  for (int i = 0; i < graph->getVertexPropertySize(); ++i)
+  std::vector<double>& domIn = graph->getDominance(DOMINANCE_INPUTFLOW);
+  std::vector<double>& domOut = graph->getDominance(DOMINANCE_OUTPUTFLOW);
+
+  for (std::size_t t = 0; t < vertices.size(); ++t)
   {
-    if (graph->getVertexProperty(i)->getName() == attrName)
-    {
-      idx = i;
-      break;
-    }
+    int v = vertices[t];
+
+    double sum = 0.;
+
+    for (int i = inOffset[v]; i < inOffset[v + 1]; ++i)
+      sum += weight[inEdges[i]];
+
+    domIn[v] = sum;
+
+    sum = 0.;
+
+    for (int i = outOffset[v]; i < outOffset[v + 1]; ++i)
+      sum += weight[outEdges[i]];
+
+    domOut[v] = sum;
+
+    combine(graph, v, v + 1);
   }
 
-  return idx;
+  graph->setDominanceType(domType);
 }
 
-int te::qt::plugins::fiocruz::FlowDominance::getEdgeWeightAttrValue(te::graph::AbstractGraph* graph, te::graph::Edge* e)
+void te::qt::plugins::fiocruz::FlowDominance::setNumberOfThreads(std::size_t numThreads)
 {
-  std::string attrName = "weight";
+  m_numThreads = numThreads;
+}
 
-  // verify what the index of the weight property
-  int idx = -1;
+void te::qt::plugins::fiocruz::FlowDominance::joinByGraphIndex(FlowGraph* graph, te::da::DataSet* dataSet, ColumnReader& idReader, ColumnReader& domReader, DominanceJoinReport& report)
+{
+  std::vector<double>& dominance = graph->getDominance();
 
-  for (int i = 0; i < graph->getEdgePropertySize(); ++i)
+  std::vector<unsigned char> matched(graph->getVertexCount(), 0);
+
+  //each unmatched id is reported once, as in joinByRowIndex
+  IdDictionary<int> unmatched;
+
+  std::vector<int> ids;
+  std::vector<double> values;
+  std::vector<int> vertices;
+
+  dataSet->moveBeforeFirst();
+
+  bool hasRows = true;
+
+  while (hasRows)
   {
-    if (graph->getEdgeProperty(i)->getName() == attrName)
+    ids.clear();
+    values.clear();
+
+    while (ids.size() < m_batchSize && (hasRows = dataSet->moveNext()))
+    {
+      if (idReader.isNull())
+        continue;
+
+      ids.push_back(idReader.getId());
+      values.push_back(domReader.getDouble());
+    }
+
+    //probe the vertex index in parallel, the values are set in row order
+    vertices.resize(ids.size());
+
+    ParallelFor(ids.size(), m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+    {
+      for (std::size_t t = begin; t < end; ++t)
+        vertices[t] = graph->getVertexIndex(ids[t]);
+    });
+
+    for (std::size_t t = 0; t < ids.size(); ++t)
     {
-      idx = i;
-      break;
+      int v = vertices[t];
+
+      if (v == -1)
+      {
+        bool added;
+
+        unmatched.add(ids[t], added);
+
+        if (added)
+          report.m_unmatchedIds.push_back(ids[t]);
+
+        continue;
+      }
+
+      dominance[v] = values[t];
+
+      if (!matched[v])
+      {
+        matched[v] = 1;
+        ++report.m_matchedVertexCount;
+      }
     }
+
+    report.m_rowCount += ids.size();
   }
+}
+
+void te::qt::plugins::fiocruz::FlowDominance::joinByRowIndex(FlowGraph* graph, te::da::DataSet* dataSet, ColumnReader& idReader, ColumnReader& domReader, DominanceJoinReport& report)
+{
+  IdDictionary<int> rowIndex;
+  std::vector<double> values;
 
-  //get value
-  if (idx != -1)
+  dataSet->moveBeforeFirst();
+
+  while (dataSet->moveNext())
   {
-    std::string weightStr = e->getAttributes()[idx]->toString();
+    if (idReader.isNull())
+      continue;
+
+    bool added;
+
+    int idx = rowIndex.add(idReader.getId(), added);
 
-    return atoi(weightStr.c_str());
+    if (added)
+      values.push_back(domReader.getDouble());
+    else
+      values[idx] = domReader.getDouble();
+
+    ++report.m_rowCount;
   }
 
-  return 0;
+  //probe the row index with each vertex, each thread writes its own vertex range
+  std::vector<double>& dominance = graph->getDominance();
+  const std::vector<int>& vertexIds = graph->getVertexIds();
+
+  std::vector<unsigned char> rowMatched(rowIndex.size(), 0);
+
+  ParallelFor(vertexIds.size(), m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    for (std::size_t v = begin; v < end; ++v)
+    {
+      int idx = rowIndex.getIndex(vertexIds[v]);
+
+      if (idx == -1)
+        continue;
+
+      dominance[v] = values[idx];
+
+      //the vertex ids are unique, so each row flag is written by a single vertex
+      rowMatched[idx] = 1;
+    }
+  });
+
+  for (std::size_t idx = 0; idx < rowIndex.size(); ++idx)
+  {
+    if (rowMatched[idx])
+      ++report.m_matchedVertexCount;
+    else
+      report.m_unmatchedIds.push_back(rowIndex.getId((int)idx));
+  }
+}
+
+void te::qt::plugins::fiocruz::FlowDominance::combine(FlowGraph* graph, std::size_t begin, std::size_t end)
+{
+  const std::vector<double>& domIn = graph->getDominance(DOMINANCE_INPUTFLOW);
+  const std::vector<double>& domOut = graph->getDominance(DOMINANCE_OUTPUTFLOW);
+
+  std::vector<double>& domNet = graph->getDominance(DOMINANCE_NETFLOW);
+  std::vector<double>& domTotal = graph->getDominance(DOMINANCE_TOTALFLOW);
+
+  for (std::size_t v = begin; v < end; ++v)
+  {
+    domNet[v] = domIn[v] - domOut[v];
+    domTotal[v] = domIn[v] + domOut[v];
+  }
 }
@@ -28,13 +28,14 @@ TerraLib Team at <terralib-team@terralib.org>.
 
 // TerraLib
 #include <terralib/dataaccess/datasource/DataSource.h>
-#include <terralib/graph/core/AbstractGraph.h>
-#include <terralib/graph/core/Edge.h>
 
+#include "../ColumnReader.h"
 #include "../Config.h"
+#include "core/FlowGraph.h"
 
 // STL
 #include <memory>
+#include <vector>
 
 namespace te
 {
@@ -44,10 +45,16 @@ namespace te
     {
       namespace fiocruz
       {
-        enum DominanceType
+        /*!
+        \struct DominanceJoinReport
+
+        \brief Result of the association of a dominance data set to the graph vertices.
+        */
+        struct DominanceJoinReport
         {
-          DOMINANCE_INPUTFLOW,
-          DOMINANCE_OUTPUTFLOW
+          std::size_t m_rowCount;             //!< Number of rows with a valid id
+          std::size_t m_matchedVertexCount;   //!< Number of vertices that received a dominance value
+          std::vector<int> m_unmatchedIds;    //!< Ids of the rows without a graph vertex, each one once and in row order
         };
 
         /*!
@@ -66,15 +73,71 @@ namespace te
 
           public:
 
-            void associate(te::graph::AbstractGraph* graph, te::da::DataSourcePtr ds, std::string dataSetName, int idIdx, int domIdx);
+            /*!
+            \brief Joins a data set with a dominance value per vertex id to the graph vertices.
+
+            The hash index of the smaller side is used: the graph vertex index is probed by
+            batches of rows in parallel or, if the data set has fewer rows than the graph has
+            vertices, the rows are indexed and probed by the vertices. The columns are read
+            with their native type. If an id is repeated, the last row is used.
+
+            The rows are always read serially, only the hash probes run in parallel, so the
+            threads help only when the data set is already in memory.
+
+            \param graph         The flow graph
+            \param ds            Data source of the dominance data set
+            \param dataSetName   Name of the dominance data set
+            \param idIdx         Position of the vertex id column
+            \param domIdx        Position of the dominance column
+
+            \return The matched and unmatched keys.
+            */
+            DominanceJoinReport associate(FlowGraph* graph, te::da::DataSourcePtr ds, std::string dataSetName, int idIdx, int domIdx);
+
+            /*!
+            \brief Calculates the dominance of all types (input, output, net and total) in one sweep over the edges.
+
+            The columns of all types are kept in the graph (see FlowGraph::getDominance(DominanceType))
+            and the column of domType is used as the graph dominance.
 
-            void calculate(te::graph::AbstractGraph* graph, DominanceType domType);
+            \param graph      The flow graph
+            \param domType    The dominance type used by the main flow
+            */
+            void calculate(FlowGraph* graph, DominanceType domType);
+
+            /*!
+            \brief Defines the number of threads used to sweep the edges.
+
+            \param numThreads   Number of worker threads, 1 uses the calling thread (default) and 0 uses one thread per core
+            */
+            void setNumberOfThreads(std::size_t numThreads);
+
+            /*!
+            \brief Recalculates the dominance only for the given vertices, used after FlowGraphImport::appendGraph.
+
+            If the graph has no dominance column, it is calculated for all vertices.
+
+            \param graph      The flow graph
+            \param domType    The dominance type used on calculate
+            \param vertices   Dense indexes of the vertices with new or changed edges
+            */
+            void update(FlowGraph* graph, DominanceType domType, const std::vector<int>& vertices);
 
           protected:
 
-            int addDominanceAttr(te::graph::AbstractGraph* graph);
+            /*! \brief Reads the data set by batches and probes the graph vertex index with each batch in parallel. */
+            void joinByGraphIndex(FlowGraph* graph, te::da::DataSet* dataSet, ColumnReader& idReader, ColumnReader& domReader, DominanceJoinReport& report);
+
+            /*! \brief Indexes all rows of the data set and probes the row index with the graph vertices in parallel. */
+            void joinByRowIndex(FlowGraph* graph, te::da::DataSet* dataSet, ColumnReader& idReader, ColumnReader& domReader, DominanceJoinReport& report);
+
+            /*! \brief Fills the net and total columns of the vertices [begin, end) from their input and output columns. */
+            void combine(FlowGraph* graph, std::size_t begin, std::size_t end);
+
+          protected:
 
-            int getEdgeWeightAttrValue(te::graph::AbstractGraph* graph, te::graph::Edge* e);
+            std::size_t m_numThreads;   //!< Number of threads used to sweep the edges and to probe the join indexes
+            std::size_t m_batchSize;    //!< Number of rows read from the dominance data set per join batch
 
         };
       }   // end namespace fiocruz
@@ -0,0 +1,938 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/FlowGraphArrowExport.cpp
+
+\brief This file defines the class used to export a flow graph to Arrow IPC files
+*/
+
+#include "FlowGraphArrowExport.h"
+
+// TerraLib
+#include <terralib/common/Exception.h>
+#include <terralib/common/Translator.h>
+
+// STL
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+  const char ARROW_MAGIC[6] = { 'A', 'R', 'R', 'O', 'W', '1' };
+
+  //values of the Arrow flatbuffers schema (Schema.fbs, Message.fbs)
+  const boost::int16_t ARROW_METADATA_V5 = 4;
+
+  const boost::uint8_t ARROW_HEADER_SCHEMA = 1;
+  const boost::uint8_t ARROW_HEADER_DICTIONARY_BATCH = 2;
+  const boost::uint8_t ARROW_HEADER_RECORD_BATCH = 3;
+
+  const boost::uint8_t ARROW_TYPE_INT = 2;
+  const boost::uint8_t ARROW_TYPE_FLOATING_POINT = 3;
+  const boost::uint8_t ARROW_TYPE_BINARY = 4;
+  const boost::uint8_t ARROW_TYPE_UTF8 = 5;
+
+  const boost::int16_t ARROW_PRECISION_DOUBLE = 2;
+
+  const std::size_t WKB_POINT_SIZE = 21;
+  const std::size_t WKB_LINE_SIZE = 41;
+
+  std::size_t Align8(std::size_t value)
+  {
+    return (value + 7) & ~(std::size_t)7;
+  }
+
+  bool IsLittleEndian()
+  {
+    boost::uint32_t value = 1;
+
+    return *reinterpret_cast<const char*>(&value) == 1;
+  }
+
+  /*!
+  \class FlatBufferBuilder
+
+  \brief Minimal flatbuffers builder, the buffer grows to the front so the children are written before their parents.
+
+  The offsets are measured from the end of the buffer, as in the reference implementation.
+  */
+  class FlatBufferBuilder
+  {
+    public:
+
+      FlatBufferBuilder()
+        : m_minAlign(1),
+          m_tableStart(0)
+      {
+      }
+
+      boost::uint32_t getSize() const
+      {
+        return (boost::uint32_t)m_buffer.size();
+      }
+
+      template<class T> void add(T value)
+      {
+        prep(sizeof(T), 0);
+        push(value);
+      }
+
+      void addOffset(boost::uint32_t offset)
+      {
+        prep(4, 0);
+        push<boost::uint32_t>(getSize() - offset + 4);
+      }
+
+      void startTable(std::size_t numFields)
+      {
+        m_fields.assign(numFields, 0);
+        m_tableStart = getSize();
+      }
+
+      template<class T> void addField(std::size_t field, T value)
+      {
+        add(value);
+        m_fields[field] = getSize();
+      }
+
+      void addFieldOffset(std::size_t field, boost::uint32_t offset)
+      {
+        addOffset(offset);
+        m_fields[field] = getSize();
+      }
+
+      boost::uint32_t endTable()
+      {
+        add<boost::int32_t>(0);
+
+        boost::uint32_t object = getSize();
+
+        //vtable: its size, the table size and the field positions from the table start
+        for (std::size_t i = m_fields.size(); i > 0; --i)
+          push<boost::uint16_t>(m_fields[i - 1] ? (boost::uint16_t)(object - m_fields[i - 1]) : (boost::uint16_t)0);
+
+        push<boost::uint16_t>((boost::uint16_t)(object - m_tableStart));
+        push<boost::uint16_t>((boost::uint16_t)(4 + 2 * m_fields.size()));
+
+        boost::int32_t vtable = (boost::int32_t)(getSize() - object);
+
+        memcpy(&m_buffer[m_buffer.size() - object], &vtable, sizeof(vtable));
+
+        return object;
+      }
+
+      boost::uint32_t createString(const std::string& value)
+      {
+        prep(4, value.size() + 1);
+        push<boost::uint8_t>(0);
+        m_buffer.insert(m_buffer.begin(), value.begin(), value.end());
+        push<boost::uint32_t>((boost::uint32_t)value.size());
+
+        return getSize();
+      }
+
+      boost::uint32_t createOffsetVector(const std::vector<boost::uint32_t>& offsets)
+      {
+        prep(4, 4 * offsets.size());
+
+        for (std::size_t i = offsets.size(); i > 0; --i)
+          addOffset(offsets[i - 1]);
+
+        push<boost::uint32_t>((boost::uint32_t)offsets.size());
+
+        return getSize();
+      }
+
+      boost::uint32_t createStructVector(const void* data, std::size_t structSize, std::size_t count)
+      {
+        std::size_t size = structSize * count;
+
+        prep(4, size);
+        prep(8, size);
+
+        const char* bytes = static_cast<const char*>(data);
+        m_buffer.insert(m_buffer.begin(), bytes, bytes + size);
+
+        push<boost::uint32_t>((boost::uint32_t)count);
+
+        return getSize();
+      }
+
+      /*! \brief Writes the root offset and returns the buffer padded to 8 bytes. */
+      std::vector<char> finish(boost::uint32_t root)
+      {
+        prep(std::max<std::size_t>(m_minAlign, 8), 4);
+        addOffset(root);
+
+        std::vector<char> result(m_buffer.begin(), m_buffer.end());
+        result.resize(Align8(result.size()), 0);
+
+        return result;
+      }
+
+    protected:
+
+      void prep(std::size_t align, std::size_t additional)
+      {
+        m_minAlign = std::max(m_minAlign, align);
+
+        std::size_t alignSize = (align - ((m_buffer.size() + additional) % align)) % align;
+
+        m_buffer.insert(m_buffer.begin(), alignSize, 0);
+      }
+
+      template<class T> void push(T value)
+      {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+
+        m_buffer.insert(m_buffer.begin(), bytes, bytes + sizeof(T));
+      }
+
+    protected:
+
+      std::vector<char> m_buffer;             //!< Buffer, the last written byte is the first one
+      std::size_t m_minAlign;                 //!< Largest alignment used
+      std::vector<boost::uint32_t> m_fields;  //!< Position of each field of the current table, 0 if absent
+      boost::uint32_t m_tableStart;           //!< Buffer size when the current table was started
+  };
+
+  struct ArrowFieldNode
+  {
+    boost::int64_t m_length;
+    boost::int64_t m_nullCount;
+  };
+
+  struct ArrowBuffer
+  {
+    boost::int64_t m_offset;
+    boost::int64_t m_length;
+  };
+
+  /*! \brief Appends a buffer to a message body, padded to 8 bytes. */
+  char* AddBuffer(std::vector<char>& body, std::vector<ArrowBuffer>& buffers, std::size_t length)
+  {
+    ArrowBuffer buffer;
+    buffer.m_offset = (boost::int64_t)body.size();
+    buffer.m_length = (boost::int64_t)length;
+
+    buffers.push_back(buffer);
+
+    body.resize(body.size() + Align8(length), 0);
+
+    return length > 0 ? &body[(std::size_t)buffer.m_offset] : 0;
+  }
+
+  /*! \brief Builds a RecordBatch table, returns its offset. */
+  boost::uint32_t AddRecordBatch(FlatBufferBuilder& fbb, std::size_t length, const std::vector<ArrowFieldNode>& nodes, const std::vector<ArrowBuffer>& buffers)
+  {
+    boost::uint32_t buffersOffset = fbb.createStructVector(buffers.data(), sizeof(ArrowBuffer), buffers.size());
+    boost::uint32_t nodesOffset = fbb.createStructVector(nodes.data(), sizeof(ArrowFieldNode), nodes.size());
+
+    fbb.startTable(5);
+    fbb.addField<boost::int64_t>(0, (boost::int64_t)length);
+    fbb.addFieldOffset(1, nodesOffset);
+    fbb.addFieldOffset(2, buffersOffset);
+
+    return fbb.endTable();
+  }
+
+  /*! \brief Builds the Message table around a header and returns the finished metadata. */
+  std::vector<char> FinishMessage(FlatBufferBuilder& fbb, boost::uint8_t headerType, boost::uint32_t header, std::size_t bodyLength)
+  {
+    fbb.startTable(5);
+    fbb.addField<boost::int64_t>(3, (boost::int64_t)bodyLength);
+    fbb.addFieldOffset(2, header);
+    fbb.addField<boost::int16_t>(0, ARROW_METADATA_V5);
+    fbb.addField<boost::uint8_t>(1, headerType);
+
+    return fbb.finish(fbb.endTable());
+  }
+
+  /*! \brief Builds a vector of KeyValue tables. */
+  boost::uint32_t AddKeyValues(FlatBufferBuilder& fbb, const std::vector<std::pair<std::string, std::string> >& values)
+  {
+    std::vector<boost::uint32_t> tables;
+
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      boost::uint32_t key = fbb.createString(values[i].first);
+      boost::uint32_t value = fbb.createString(values[i].second);
+
+      fbb.startTable(2);
+      fbb.addFieldOffset(0, key);
+      fbb.addFieldOffset(1, value);
+
+      tables.push_back(fbb.endTable());
+    }
+
+    return fbb.createOffsetVector(tables);
+  }
+
+  boost::uint32_t AddIntType(FlatBufferBuilder& fbb)
+  {
+    fbb.startTable(2);
+    fbb.addField<boost::int32_t>(0, 32);
+    fbb.addField<boost::uint8_t>(1, 1);
+
+    return fbb.endTable();
+  }
+
+  void WriteLE(char* data, double value)
+  {
+    memcpy(data, &value, sizeof(double));
+  }
+}
+
+te::qt::plugins::fiocruz::FlowGraphArrowExport::FlowGraphArrowExport()
+{
+  m_batchSize = 65536;
+}
+
+te::qt::plugins::fiocruz::FlowGraphArrowExport::~FlowGraphArrowExport()
+{
+
+}
+
+void te::qt::plugins::fiocruz::FlowGraphArrowExport::exportEdges(FlowGraph* graph, const std::string& fileName)
+{
+  assert(graph);
+
+  std::vector<Column> columns;
+
+  getEdgeColumns(graph, columns);
+
+  write(graph, columns, graph->getEdgeCount(), "LineString", fileName);
+}
+
+void te::qt::plugins::fiocruz::FlowGraphArrowExport::exportVertices(FlowGraph* graph, const std::string& fileName)
+{
+  assert(graph);
+
+  std::vector<Column> columns;
+
+  getVertexColumns(graph, columns);
+
+  write(graph, columns, graph->getVertexCount(), "Point", fileName);
+}
+
+void te::qt::plugins::fiocruz::FlowGraphArrowExport::setBatchSize(std::size_t batchSize)
+{
+  m_batchSize = batchSize;
+}
+
+namespace
+{
+  template<class T> std::function<void(std::size_t, std::size_t, char*)> MakeIntFill(const std::vector<T>& values)
+  {
+    const std::vector<T>* column = &values;
+
+    return [column](std::size_t begin, std::size_t end, char* data)
+    {
+      boost::int32_t* out = reinterpret_cast<boost::int32_t*>(data);
+
+      for (std::size_t i = begin; i < end; ++i)
+        *out++ = (boost::int32_t)(*column)[i];
+    };
+  }
+
+  std::function<void(std::size_t, std::size_t, char*)> MakeDoubleFill(const std::vector<double>& values)
+  {
+    const std::vector<double>* column = &values;
+
+    return [column](std::size_t begin, std::size_t end, char* data)
+    {
+      if (end > begin)
+        memcpy(data, &(*column)[begin], (end - begin) * sizeof(double));
+    };
+  }
+}
+
+void te::qt::plugins::fiocruz::FlowGraphArrowExport::getEdgeColumns(FlowGraph* graph, std::vector<Column>& columns)
+{
+  const std::vector<int>& ids = graph->getVertexIds();
+  const std::vector<boost::uint32_t>& names = graph->getVertexNameHandles();
+  const std::vector<double>& xs = graph->getVertexX();
+  const std::vector<double>& ys = graph->getVertexY();
+  const std::vector<int>& edgeFrom = graph->getEdgeFrom();
+  const std::vector<int>& edgeTo = graph->getEdgeTo();
+
+  Column column;
+
+  column.m_name = "index";
+  column.m_type = COLUMN_INT32;
+  column.m_width = 4;
+  column.m_fill = [](std::size_t begin, std::size_t end, char* data)
+  {
+    boost::int32_t* out = reinterpret_cast<boost::int32_t*>(data);
+
+    for (std::size_t e = begin; e < end; ++e)
+      *out++ = (boost::int32_t)e;
+  };
+  columns.push_back(column);
+
+  //from_id, from_name, to_id and to_name, the vertex columns are read through the edge ends
+  const std::vector<int>* ends[2] = { &edgeFrom, &edgeTo };
+  const char* idNames[2] = { "from_id", "to_id" };
+  const char* nameNames[2] = { "from_name", "to_name" };
+
+  for (int t = 0; t < 2; ++t)
+  {
+    const std::vector<int>* end = ends[t];
+
+    column.m_name = idNames[t];
+    column.m_type = COLUMN_INT32;
+    column.m_width = 4;
+    column.m_fill = [end, &ids](std::size_t first, std::size_t last, char* data)
+    {
+      boost::int32_t* out = reinterpret_cast<boost::int32_t*>(data);
+
+      for (std::size_t e = first; e < last; ++e)
+        *out++ = ids[(*end)[e]];
+    };
+    columns.push_back(column);
+
+    column.m_name = nameNames[t];
+    column.m_type = COLUMN_NAME;
+    column.m_width = 4;
+    column.m_fill = [end, &names](std::size_t first, std::size_t last, char* data)
+    {
+      boost::int32_t* out = reinterpret_cast<boost::int32_t*>(data);
+
+      for (std::size_t e = first; e < last; ++e)
+        *out++ = (boost::int32_t)names[(*end)[e]];
+    };
+    columns.push_back(column);
+  }
+
+  column.m_name = "weight";
+  column.m_type = COLUMN_DOUBLE;
+  column.m_width = 8;
+  column.m_fill = MakeDoubleFill(graph->getWeight());
+  columns.push_back(column);
+
+  column.m_name = "distance";
+  column.m_fill = MakeDoubleFill(graph->getDistance());
+  columns.push_back(column);
+
+  if (graph->hasMainFlow())
+  {
+    column.m_name = "main_flow";
+    column.m_type = COLUMN_INT32;
+    column.m_width = 4;
+    column.m_fill = MakeIntFill(graph->getMainFlow());
+    columns.push_back(column);
+  }
+
+  if (graph->hasFlowRank())
+  {
+    column.m_name = "flow_rank";
+    column.m_type = COLUMN_INT32;
+    column.m_width = 4;
+    column.m_fill = MakeIntFill(graph->getFlowRank());
+    columns.push_back(column);
+
+    column.m_name = "flow_share";
+    column.m_type = COLUMN_DOUBLE;
+    column.m_width = 8;
+    column.m_fill = MakeDoubleFill(graph->getFlowShare());
+    columns.push_back(column);
+  }
+
+  if (graph->hasRecordCount())
+  {
+    column.m_name = "records";
+    column.m_type = COLUMN_INT32;
+    column.m_width = 4;
+    column.m_fill = MakeIntFill(graph->getRecordCount());
+    columns.push_back(column);
+  }
+
+  //WKB line string: byte order, type, number of points and the two points
+  column.m_name = "line";
+  column.m_type = COLUMN_WKB;
+  column.m_width = WKB_LINE_SIZE;
+  column.m_fill = [&edgeFrom, &edgeTo, &xs, &ys](std::size_t begin, std::size_t end, char* data)
+  {
+    const boost::uint32_t header[2] = { 2, 2 };
+
+    for (std::size_t e = begin; e < end; ++e, data += WKB_LINE_SIZE)
+    {
+      data[0] = 1;
+      memcpy(data + 1, header, sizeof(header));
+
+      WriteLE(data + 9, xs[edgeFrom[e]]);
+      WriteLE(data + 17, ys[edgeFrom[e]]);
+      WriteLE(data + 25, xs[edgeTo[e]]);
+      WriteLE(data + 33, ys[edgeTo[e]]);
+    }
+  };
+  columns.push_back(column);
+}
+
+void te::qt::plugins::fiocruz::FlowGraphArrowExport::getVertexColumns(FlowGraph* graph, std::vector<Column>& columns)
+{
+  const std::vector<double>& xs = graph->getVertexX();
+  const std::vector<double>& ys = graph->getVertexY();
+
+  Column column;
+
+  column.m_name = "index";
+  column.m_type = COLUMN_INT32;
+  column.m_width = 4;
+  column.m_fill = MakeIntFill(graph->getVertexIds());
+  columns.push_back(column);
+
+  column.m_name = "name";
+  column.m_type = COLUMN_NAME;
+  column.m_fill = MakeIntFill(graph->getVertexNameHandles());
+  columns.push_back(column);
+
+  //WKB point: byte order, type and the point
+  column.m_name = "coords";
+  column.m_type = COLUMN_WKB;
+  column.m_width = WKB_POINT_SIZE;
+  column.m_fill = [&xs, &ys](std::size_t begin, std::size_t end, char* data)
+  {
+    const boost::uint32_t type = 1;
+
+    for (std::size_t v = begin; v < end; ++v, data += WKB_POINT_SIZE)
+    {
+      data[0] = 1;
+      memcpy(data + 1, &type, sizeof(type));
+
+      WriteLE(data + 5, xs[v]);
+      WriteLE(data + 13, ys[v]);
+    }
+  };
+  columns.push_back(column);
+
+  if (graph->hasStatistics())
+  {
+    column.m_type = COLUMN_INT32;
+    column.m_width = 4;
+
+    column.m_name = "in_flows";
+    column.m_fill = MakeIntFill(graph->getInFlows());
+    columns.push_back(column);
+
+    column.m_name = "out_flows";
+    column.m_fill = MakeIntFill(graph->getOutFlows());
+    columns.push_back(column);
+
+    column.m_type = COLUMN_DOUBLE;
+    column.m_width = 8;
+
+    column.m_name = "sum_in";
+    column.m_fill = MakeDoubleFill(graph->getSumIn());
+    columns.push_back(column);
+
+    column.m_name = "sum_out";
+    column.m_fill = MakeDoubleFill(graph->getSumOut());
+    columns.push_back(column);
+
+    if (graph->hasExtendedStatistics())
+    {
+      column.m_name = "mean_in";
+      column.m_fill = MakeDoubleFill(graph->getMeanIn());
+      columns.push_back(column);
+
+      column.m_name = "mean_out";
+      column.m_fill = MakeDoubleFill(graph->getMeanOut());
+      columns.push_back(column);
+
+      column.m_name = "max_in";
+      column.m_fill = MakeDoubleFill(graph->getMaxIn());
+      columns.push_back(column);
+
+      column.m_name = "max_out";
+      column.m_fill = MakeDoubleFill(graph->getMaxOut());
+      columns.push_back(column);
+    }
+  }
+
+  column.m_type = COLUMN_DOUBLE;
+  column.m_width = 8;
+
+  if (graph->hasDominance())
+  {
+    column.m_name = "dominance";
+    column.m_fill = MakeDoubleFill(graph->getDominance());
+    columns.push_back(column);
+  }
+
+  if (graph->hasDominanceModes())
+  {//the order must follow the DominanceType values
+    const char* domProps[DOMINANCE_TYPE_COUNT] = { "dom_in", "dom_out", "dom_net", "dom_total" };
+
+    for (int t = 0; t < DOMINANCE_TYPE_COUNT; ++t)
+    {
+      column.m_name = domProps[t];
+      column.m_fill = MakeDoubleFill(graph->getDominance((DominanceType)t));
+      columns.push_back(column);
+    }
+  }
+
+  column.m_type = COLUMN_INT32;
+  column.m_width = 4;
+
+  if (graph->hasMainFlow())
+  {
+    column.m_name = "level";
+    column.m_fill = MakeIntFill(graph->getLevel());
+    columns.push_back(column);
+
+    if (graph->hasMainFlowStatistics())
+    {
+      column.m_name = "destiny";
+      column.m_fill = MakeIntFill(graph->getDestiny());
+      columns.push_back(column);
+
+      column.m_name = "tree";
+      column.m_fill = MakeIntFill(graph->getTree());
+      columns.push_back(column);
+
+      column.m_name = "input";
+      column.m_fill = MakeIntFill(graph->getInput());
+      columns.push_back(column);
+    }
+  }
+}
+
+void te::qt::plugins::fiocruz::FlowGraphArrowExport::write(FlowGraph* graph, const std::vector<Column>& columns, std::size_t rowCount, const std::string& geometryType, const std::string& fileName)
+{
+  if (!IsLittleEndian())
+    throw te::common::Exception(TE_TR("The Arrow export requires a little endian architecture."));
+
+  std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open())
+    throw te::common::Exception(TE_TR("Could not create the Arrow file."));
+
+  //file magic, padded to 8 bytes
+  const char padding[2] = { 0, 0 };
+
+  out.write(ARROW_MAGIC, sizeof(ARROW_MAGIC));
+  out.write(padding, sizeof(padding));
+
+  //schema, it is written again in the footer
+  std::string geometryColumn;
+
+  for (std::size_t c = 0; c < columns.size(); ++c)
+  {
+    if (columns[c].m_type == COLUMN_WKB)
+      geometryColumn = columns[c].m_name;
+  }
+
+  std::ostringstream crs;
+
+  if (graph->getSRID() > 0)
+    crs << "\"EPSG:" << graph->getSRID() << "\"";
+  else
+    crs << "null";
+
+  std::string geoMetadata = "{\"version\":\"1.0.0\",\"primary_column\":\"" + geometryColumn + "\",\"columns\":{\"" + geometryColumn +
+                            "\":{\"encoding\":\"WKB\",\"geometry_types\":[\"" + geometryType + "\"],\"crs\":" + crs.str() + "}}}";
+
+  std::string extensionMetadata = graph->getSRID() > 0 ? "{\"crs\":" + crs.str() + ",\"crs_type\":\"authority_code\"}" : "{}";
+
+  //the dictionary ids are the positions of the name columns
+  std::vector<boost::int64_t> dictionaryIds(columns.size(), -1);
+
+  for (std::size_t c = 0; c < columns.size(); ++c)
+  {
+    if (columns[c].m_type == COLUMN_NAME)
+      dictionaryIds[c] = (boost::int64_t)c;
+  }
+
+  std::function<boost::uint32_t(FlatBufferBuilder&)> addSchema = [&](FlatBufferBuilder& fbb)
+  {
+    std::vector<boost::uint32_t> fields;
+
+    for (std::size_t c = 0; c < columns.size(); ++c)
+    {
+      const Column& column = columns[c];
+
+      boost::uint32_t name = fbb.createString(column.m_name);
+
+      boost::uint8_t typeType = ARROW_TYPE_INT;
+      boost::uint32_t type = 0;
+
+      if (column.m_type == COLUMN_INT32)
+      {
+        type = AddIntType(fbb);
+      }
+      else if (column.m_type == COLUMN_DOUBLE)
+      {
+        typeType = ARROW_TYPE_FLOATING_POINT;
+
+        fbb.startTable(1);
+        fbb.addField<boost::int16_t>(0, ARROW_PRECISION_DOUBLE);
+        type = fbb.endTable();
+      }
+      else
+      {
+        typeType = column.m_type == COLUMN_NAME ? ARROW_TYPE_UTF8 : ARROW_TYPE_BINARY;
+
+        fbb.startTable(0);
+        type = fbb.endTable();
+      }
+
+      boost::uint32_t dictionary = 0;
+
+      if (column.m_type == COLUMN_NAME)
+      {
+        boost::uint32_t indexType = AddIntType(fbb);
+
+        fbb.startTable(4);
+        fbb.addField<boost::int64_t>(0, dictionaryIds[c]);
+        fbb.addFieldOffset(1, indexType);
+        dictionary = fbb.endTable();
+      }
+
+      boost::uint32_t metadata = 0;
+
+      if (column.m_type == COLUMN_WKB)
+      {
+        std::vector<std::pair<std::string, std::string> > values;
+        values.push_back(std::make_pair(std::string("ARROW:extension:name"), std::string("geoarrow.wkb")));
+        values.push_back(std::make_pair(std::string("ARROW:extension:metadata"), extensionMetadata));
+
+        metadata = AddKeyValues(fbb, values);
+      }
+
+      boost::uint32_t children = fbb.createOffsetVector(std::vector<boost::uint32_t>());
+
+      fbb.startTable(7);
+      fbb.addFieldOffset(0, name);
+      fbb.addFieldOffset(3, type);
+      fbb.addFieldOffset(5, children);
+
+      if (dictionary)
+        fbb.addFieldOffset(4, dictionary);
+
+      if (metadata)
+        fbb.addFieldOffset(6, metadata);
+
+      fbb.addField<boost::uint8_t>(1, 0);
+      fbb.addField<boost::uint8_t>(2, typeType);
+
+      fields.push_back(fbb.endTable());
+    }
+
+    boost::uint32_t fieldVector = fbb.createOffsetVector(fields);
+
+    std::vector<std::pair<std::string, std::string> > values(1, std::make_pair(std::string("geo"), geoMetadata));
+
+    boost::uint32_t metadata = AddKeyValues(fbb, values);
+
+    fbb.startTable(4);
+    fbb.addFieldOffset(1, fieldVector);
+    fbb.addFieldOffset(2, metadata);
+    fbb.addField<boost::int16_t>(0, 0);
+
+    return fbb.endTable();
+  };
+
+  {
+    FlatBufferBuilder fbb;
+
+    boost::uint32_t schema = addSchema(fbb);
+
+    writeMessage(out, FinishMessage(fbb, ARROW_HEADER_SCHEMA, schema, 0), std::vector<char>());
+  }
+
+  //one dictionary for each name column, with all names of the graph pool
+  boost::shared_ptr<StringPool> namePool = graph->getNamePool();
+
+  std::vector<Block> dictionaryBlocks;
+
+  for (std::size_t c = 0; c < columns.size(); ++c)
+  {
+    if (columns[c].m_type != COLUMN_NAME)
+      continue;
+
+    std::size_t nNames = namePool->size();
+
+    std::size_t nameBytes = 0;
+
+    for (std::size_t i = 0; i < nNames; ++i)
+      nameBytes += namePool->get((boost::uint32_t)i).size();
+
+    std::vector<char> body;
+    std::vector<ArrowBuffer> buffers;
+
+    AddBuffer(body, buffers, 0);
+
+    AddBuffer(body, buffers, (nNames + 1) * sizeof(boost::int32_t));
+    AddBuffer(body, buffers, nameBytes);
+
+    //the buffers are read after the body is resized
+    char* offsetData = &body[(std::size_t)buffers[1].m_offset];
+    char* charData = nameBytes > 0 ? &body[(std::size_t)buffers[2].m_offset] : 0;
+
+    boost::int32_t offset = 0;
+
+    for (std::size_t i = 0; i < nNames; ++i)
+    {
+      const std::string& name = namePool->get((boost::uint32_t)i);
+
+      memcpy(offsetData + i * sizeof(boost::int32_t), &offset, sizeof(offset));
+
+      if (!name.empty())
+        memcpy(charData + offset, name.data(), name.size());
+
+      offset += (boost::int32_t)name.size();
+    }
+
+    memcpy(offsetData + nNames * sizeof(boost::int32_t), &offset, sizeof(offset));
+
+    std::vector<ArrowFieldNode> nodes(1);
+    nodes[0].m_length = (boost::int64_t)nNames;
+    nodes[0].m_nullCount = 0;
+
+    FlatBufferBuilder fbb;
+
+    boost::uint32_t recordBatch = AddRecordBatch(fbb, nNames, nodes, buffers);
+
+    fbb.startTable(3);
+    fbb.addField<boost::int64_t>(0, dictionaryIds[c]);
+    fbb.addFieldOffset(1, recordBatch);
+    boost::uint32_t dictionaryBatch = fbb.endTable();
+
+    dictionaryBlocks.push_back(writeMessage(out, FinishMessage(fbb, ARROW_HEADER_DICTIONARY_BATCH, dictionaryBatch, body.size()), body));
+  }
+
+  //record batches, only one batch is kept in memory
+  std::vector<Block> recordBlocks;
+
+  std::size_t batchSize = std::max<std::size_t>(m_batchSize, 1);
+
+  std::vector<char> body;
+
+  for (std::size_t begin = 0; begin < rowCount || (rowCount == 0 && begin == 0); begin += batchSize)
+  {
+    std::size_t end = std::min(rowCount, begin + batchSize);
+    std::size_t length = end - begin;
+
+    body.clear();
+
+    std::vector<ArrowBuffer> buffers;
+    std::vector<ArrowFieldNode> nodes;
+
+    for (std::size_t c = 0; c < columns.size(); ++c)
+    {
+      const Column& column = columns[c];
+
+      ArrowFieldNode node;
+      node.m_length = (boost::int64_t)length;
+      node.m_nullCount = 0;
+
+      nodes.push_back(node);
+
+      //no validity bitmap, all values are valid
+      AddBuffer(body, buffers, 0);
+
+      if (column.m_type == COLUMN_WKB)
+      {
+        std::size_t offsetPos = body.size();
+
+        AddBuffer(body, buffers, (length + 1) * sizeof(boost::int32_t));
+
+        for (std::size_t i = 0; i <= length; ++i)
+        {
+          boost::int32_t offset = (boost::int32_t)(i * column.m_width);
+
+          memcpy(&body[offsetPos + i * sizeof(boost::int32_t)], &offset, sizeof(offset));
+        }
+      }
+
+      std::size_t dataPos = body.size();
+
+      AddBuffer(body, buffers, length * column.m_width);
+
+      if (length > 0)
+        column.m_fill(begin, end, &body[dataPos]);
+    }
+
+    FlatBufferBuilder fbb;
+
+    boost::uint32_t recordBatch = AddRecordBatch(fbb, length, nodes, buffers);
+
+    recordBlocks.push_back(writeMessage(out, FinishMessage(fbb, ARROW_HEADER_RECORD_BATCH, recordBatch, body.size()), body));
+
+    if (rowCount == 0)
+      break;
+  }
+
+  //end of stream marker
+  const boost::int32_t endOfStream[2] = { -1, 0 };
+
+  out.write(reinterpret_cast<const char*>(endOfStream), sizeof(endOfStream));
+
+  //footer
+  {
+    FlatBufferBuilder fbb;
+
+    boost::uint32_t schema = addSchema(fbb);
+    boost::uint32_t records = fbb.createStructVector(recordBlocks.data(), sizeof(Block), recordBlocks.size());
+    boost::uint32_t dictionaries = fbb.createStructVector(dictionaryBlocks.data(), sizeof(Block), dictionaryBlocks.size());
+
+    fbb.startTable(5);
+    fbb.addFieldOffset(1, schema);
+    fbb.addFieldOffset(2, dictionaries);
+    fbb.addFieldOffset(3, records);
+    fbb.addField<boost::int16_t>(0, ARROW_METADATA_V5);
+
+    std::vector<char> footer = fbb.finish(fbb.endTable());
+
+    boost::int32_t footerSize = (boost::int32_t)footer.size();
+
+    out.write(&footer[0], footer.size());
+    out.write(reinterpret_cast<const char*>(&footerSize), sizeof(footerSize));
+    out.write(ARROW_MAGIC, sizeof(ARROW_MAGIC));
+  }
+
+  out.close();
+
+  if (out.fail())
+    throw te::common::Exception(TE_TR("Error writing the Arrow file."));
+}
+
+te::qt::plugins::fiocruz::FlowGraphArrowExport::Block te::qt::plugins::fiocruz::FlowGraphArrowExport::writeMessage(std::ofstream& out, const std::vector<char>& metadata, const std::vector<char>& body)
+{
+  Block block;
+  block.m_offset = (boost::int64_t)out.tellp();
+  block.m_metaDataLength = (boost::int32_t)(8 + metadata.size());
+  block.m_padding = 0;
+  block.m_bodyLength = (boost::int64_t)body.size();
+
+  //continuation marker and metadata size, the metadata is already padded to 8 bytes
+  const boost::int32_t prefix[2] = { -1, (boost::int32_t)metadata.size() };
+
+  out.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+  out.write(&metadata[0], metadata.size());
+
+  if (!body.empty())
+    out.write(&body[0], body.size());
+
+  return block;
+}
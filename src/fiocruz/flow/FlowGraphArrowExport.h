@@ -0,0 +1,152 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/FlowGraphArrowExport.h
+
+\brief This file defines the class used to export a flow graph to Arrow IPC files
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHARROWEXPORT_H
+#define __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHARROWEXPORT_H
+
+#include "../Config.h"
+#include "core/FlowGraph.h"
+
+// STL
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/cstdint.hpp>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \class FlowGraphArrowExport
+
+        \brief This class is used to export the edges or the vertices of a flow graph to an Arrow IPC file (Feather v2).
+
+        The columns are the same of FlowGraphExport. The rows are written in record
+        batches of m_batchSize rows, created directly from the graph columns, so each
+        batch can be read in parallel. The names are dictionary encoded with the graph
+        name pool and the geometry column is WKB (a line for the edges and a point for
+        the vertices), tagged with the geoarrow.wkb extension and with the "geo" schema
+        metadata used by GeoParquet readers.
+
+        The file is written in little endian byte order, as required by the Arrow metadata.
+        */
+        class FlowGraphArrowExport
+        {
+
+          public:
+
+            FlowGraphArrowExport();
+
+            ~FlowGraphArrowExport();
+
+          public:
+
+            /*!
+            \brief Writes the edges of a flow graph to an Arrow IPC file.
+
+            \exception te::common::Exception It throws an exception if the file can not be written.
+            */
+            void exportEdges(FlowGraph* graph, const std::string& fileName);
+
+            /*!
+            \brief Writes the vertices of a flow graph to an Arrow IPC file.
+
+            \exception te::common::Exception It throws an exception if the file can not be written.
+            */
+            void exportVertices(FlowGraph* graph, const std::string& fileName);
+
+            /*! \brief Defines the number of rows of each record batch (default 65536). */
+            void setBatchSize(std::size_t batchSize);
+
+          protected:
+
+            /*!
+            \enum ColumnType
+
+            \brief Arrow types used by the exported columns.
+            */
+            enum ColumnType
+            {
+              COLUMN_INT32,         //!< Signed 32 bits integer
+              COLUMN_DOUBLE,        //!< 64 bits floating point
+              COLUMN_NAME,          //!< Int32 index into the name dictionary (utf8 values)
+              COLUMN_WKB            //!< Binary with a fixed size WKB geometry per row
+            };
+
+            /*!
+            \struct Column
+
+            \brief Exported column, the values of the rows [begin, end) are written by the fill function.
+            */
+            struct Column
+            {
+              std::string m_name;
+              ColumnType m_type;
+              std::size_t m_width;    //!< Size in bytes of the value of one row
+              std::function<void(std::size_t begin, std::size_t end, char* data)> m_fill;
+            };
+
+            /*!
+            \struct Block
+
+            \brief Position of a message in the file, as stored in the file footer.
+            */
+            struct Block
+            {
+              boost::int64_t m_offset;
+              boost::int32_t m_metaDataLength;
+              boost::int32_t m_padding;
+              boost::int64_t m_bodyLength;
+            };
+
+            void getEdgeColumns(FlowGraph* graph, std::vector<Column>& columns);
+
+            void getVertexColumns(FlowGraph* graph, std::vector<Column>& columns);
+
+            /*! \brief Writes the schema, the name dictionaries, the record batches and the footer. */
+            void write(FlowGraph* graph, const std::vector<Column>& columns, std::size_t rowCount, const std::string& geometryType, const std::string& fileName);
+
+            /*! \brief Writes a message with its metadata and body and returns its block. */
+            Block writeMessage(std::ofstream& out, const std::vector<char>& metadata, const std::vector<char>& body);
+
+          protected:
+
+            std::size_t m_batchSize;    //!< Number of rows of each record batch
+
+        };
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHARROWEXPORT_H
@@ -0,0 +1,440 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/FlowGraphConverter.cpp
+
+\brief This file defines the Flow Graph Converter class
+*/
+
+#include "FlowGraphConverter.h"
+#include "PooledStringData.h"
+
+//terralib
+#include <terralib/datatype/SimpleData.h>
+#include <terralib/datatype/SimpleProperty.h>
+#include <terralib/datatype/StringProperty.h>
+#include <terralib/geometry/GeometryProperty.h>
+#include <terralib/geometry/Point.h>
+#include <terralib/graph/Globals.h>
+#include <terralib/graph/core/AbstractGraphFactory.h>
+#include <terralib/graph/core/GraphMetadata.h>
+#include <terralib/graph/core/Edge.h>
+#include <terralib/graph/core/Vertex.h>
+#include <terralib/graph/iterator/MemoryIterator.h>
+
+te::qt::plugins::fiocruz::FlowGraphConverter::FlowGraphConverter()
+{
+}
+
+te::qt::plugins::fiocruz::FlowGraphConverter::~FlowGraphConverter()
+{
+
+}
+
+te::graph::AbstractGraph* te::qt::plugins::fiocruz::FlowGraphConverter::toAbstractGraph(FlowGraph* flowGraph)
+{
+  assert(flowGraph);
+
+  std::string graphName = "flowGraph";
+
+  // data source information
+  std::map<std::string, std::string> connInfo;
+
+  // graph type
+  std::string graphType = te::graph::Globals::sm_factoryGraphTypeBidirectionalGraph;
+
+  // graph information
+  std::map<std::string, std::string> graphInfo;
+  graphInfo["GRAPH_DATA_SOURCE_TYPE"] = "MEM";
+  graphInfo["GRAPH_NAME"] = graphName;
+  graphInfo["GRAPH_DESCRIPTION"] = "Generated by Flow Builder.";
+
+  te::graph::AbstractGraph* graph = te::graph::AbstractGraphFactory::make(graphType, connInfo, graphInfo);
+
+  graph->getMetadata()->setSRID(flowGraph->getSRID());
+
+  buildVertexProperties(graph, flowGraph);
+
+  buildEdgeProperties(graph, flowGraph);
+
+  int vertexAttrSize = graph->getMetadata()->getVertexPropertySize();
+  int edgeAttrSize = graph->getMetadata()->getEdgePropertySize();
+
+  //create vertex objects
+  const std::vector<int>& ids = flowGraph->getVertexIds();
+  const std::vector<boost::uint32_t>& names = flowGraph->getVertexNameHandles();
+  boost::shared_ptr<StringPool> namePool = flowGraph->getNamePool();
+  const std::vector<double>& xs = flowGraph->getVertexX();
+  const std::vector<double>& ys = flowGraph->getVertexY();
+
+  for (std::size_t v = 0; v < flowGraph->getVertexCount(); ++v)
+  {
+    te::graph::Vertex* vertex = new te::graph::Vertex(ids[v]);
+    vertex->setAttributeVecSize(vertexAttrSize);
+
+    int idx = 0;
+
+    vertex->addAttribute(idx++, new PooledStringData(namePool, names[v]));
+    vertex->addAttribute(idx++, new te::gm::Point(xs[v], ys[v], flowGraph->getSRID()));
+
+    if (flowGraph->hasStatistics())
+    {
+      vertex->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getInFlows()[v]));
+      vertex->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getOutFlows()[v]));
+      vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getSumIn()[v]));
+      vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getSumOut()[v]));
+
+      if (flowGraph->hasExtendedStatistics())
+      {
+        vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getMeanIn()[v]));
+        vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getMeanOut()[v]));
+        vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getMaxIn()[v]));
+        vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getMaxOut()[v]));
+      }
+    }
+
+    if (flowGraph->hasDominance())
+      vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getDominance()[v]));
+
+    if (flowGraph->hasDominanceModes())
+    {
+      for (int t = 0; t < DOMINANCE_TYPE_COUNT; ++t)
+        vertex->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getDominance((DominanceType)t)[v]));
+    }
+
+    if (flowGraph->hasMainFlow())
+    {
+      vertex->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getLevel()[v]));
+
+      if (flowGraph->hasMainFlowStatistics())
+      {
+        vertex->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getDestiny()[v]));
+        vertex->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getTree()[v]));
+        vertex->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getInput()[v]));
+      }
+    }
+
+    graph->add(vertex);
+  }
+
+  //create edge objects
+  const std::vector<int>& from = flowGraph->getEdgeFrom();
+  const std::vector<int>& to = flowGraph->getEdgeTo();
+
+  for (std::size_t e = 0; e < flowGraph->getEdgeCount(); ++e)
+  {
+    int fromId = ids[from[e]];
+    int toId = ids[to[e]];
+
+    te::graph::Edge* edge = new te::graph::Edge((int)e, fromId, toId);
+    edge->setAttributeVecSize(edgeAttrSize);
+
+    edge->addAttribute(0, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(fromId));
+    edge->addAttribute(1, new PooledStringData(namePool, names[from[e]]));
+    edge->addAttribute(2, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(toId));
+    edge->addAttribute(3, new PooledStringData(namePool, names[to[e]]));
+    edge->addAttribute(4, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getWeight()[e]));
+    edge->addAttribute(5, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getDistance()[e]));
+
+    int idx = 6;
+
+    if (flowGraph->hasMainFlow())
+      edge->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getMainFlow()[e]));
+
+    if (flowGraph->hasFlowRank())
+    {
+      edge->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getFlowRank()[e]));
+      edge->addAttribute(idx++, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(flowGraph->getFlowShare()[e]));
+    }
+
+    if (flowGraph->hasRecordCount())
+      edge->addAttribute(idx++, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(flowGraph->getRecordCount()[e]));
+
+    graph->add(edge);
+  }
+
+  return graph;
+}
+
+te::qt::plugins::fiocruz::FlowGraph* te::qt::plugins::fiocruz::FlowGraphConverter::fromAbstractGraph(te::graph::AbstractGraph* graph)
+{
+  assert(graph);
+
+  std::auto_ptr<FlowGraph> flowGraph(new FlowGraph());
+
+  flowGraph->setSRID(graph->getMetadata()->getSRID());
+
+  int nameIdx = getVertexAttrIdx(graph, "name");
+  int coordsIdx = getVertexAttrIdx(graph, "coords");
+  int weightIdx = getEdgeAttrIdx(graph, "weight");
+  int distIdx = getEdgeAttrIdx(graph, "distance");
+
+  std::auto_ptr<te::graph::MemoryIterator> memIt(new te::graph::MemoryIterator(graph));
+
+  //vertex objects
+  te::graph::Vertex* vertex = memIt->getFirstVertex();
+
+  while (vertex)
+  {
+    std::string name;
+    double x = 0.;
+    double y = 0.;
+
+    if (nameIdx != -1 && vertex->getAttributes()[nameIdx])
+      name = vertex->getAttributes()[nameIdx]->toString();
+
+    if (coordsIdx != -1)
+    {
+      te::gm::Point* p = dynamic_cast<te::gm::Point*>(vertex->getAttributes()[coordsIdx]);
+
+      if (p)
+      {
+        x = p->getX();
+        y = p->getY();
+      }
+    }
+
+    flowGraph->addVertex(vertex->getId(), name, x, y);
+
+    vertex = memIt->getNextVertex();
+  }
+
+  //edge objects
+  te::graph::Edge* edge = memIt->getFirstEdge();
+
+  while (edge)
+  {
+    int from = flowGraph->getVertexIndex(edge->getIdFrom());
+    int to = flowGraph->getVertexIndex(edge->getIdTo());
+
+    if (from != -1 && to != -1)
+    {
+      double weight = 0.;
+      double distance = 0.;
+
+      if (weightIdx != -1 && edge->getAttributes()[weightIdx])
+        weight = atof(edge->getAttributes()[weightIdx]->toString().c_str());
+
+      if (distIdx != -1 && edge->getAttributes()[distIdx])
+        distance = atof(edge->getAttributes()[distIdx]->toString().c_str());
+
+      flowGraph->addEdge(from, to, weight, distance);
+    }
+
+    edge = memIt->getNextEdge();
+  }
+
+  flowGraph->build();
+
+  return flowGraph.release();
+}
+
+void te::qt::plugins::fiocruz::FlowGraphConverter::buildVertexProperties(te::graph::AbstractGraph* graph, FlowGraph* flowGraph)
+{
+  {
+    te::dt::SimpleProperty* p = new te::dt::StringProperty("name");
+    p->setParent(0);
+    p->setId(0);
+    graph->addVertexProperty(p);
+  }
+
+  {
+    te::gm::GeometryProperty* gProp = new te::gm::GeometryProperty("coords");
+    gProp->setId(0);
+    gProp->setGeometryType(te::gm::PointType);
+    gProp->setSRID(flowGraph->getSRID());
+    graph->addVertexProperty(gProp);
+  }
+
+  std::vector<std::pair<std::string, int> > statProps;
+
+  if (flowGraph->hasStatistics())
+  {
+    statProps.push_back(std::make_pair("in_flows", (int)te::dt::INT32_TYPE));    // numero de fluxos de entrada
+    statProps.push_back(std::make_pair("out_flows", (int)te::dt::INT32_TYPE));   // numero de fluxos de saida
+    statProps.push_back(std::make_pair("sum_in", (int)te::dt::DOUBLE_TYPE));     // somatorio dos valores dos fluxos de entrada
+    statProps.push_back(std::make_pair("sum_out", (int)te::dt::DOUBLE_TYPE));    // somatorio dos valores dos fluxos de saida
+
+    if (flowGraph->hasExtendedStatistics())
+    {
+      statProps.push_back(std::make_pair("mean_in", (int)te::dt::DOUBLE_TYPE));  // media dos valores dos fluxos de entrada
+      statProps.push_back(std::make_pair("mean_out", (int)te::dt::DOUBLE_TYPE)); // media dos valores dos fluxos de saida
+      statProps.push_back(std::make_pair("max_in", (int)te::dt::DOUBLE_TYPE));   // maior valor dos fluxos de entrada
+      statProps.push_back(std::make_pair("max_out", (int)te::dt::DOUBLE_TYPE));  // maior valor dos fluxos de saida
+    }
+  }
+
+  for (std::size_t t = 0; t < statProps.size(); ++t)
+  {
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty(statProps[t].first, statProps[t].second);
+    p->setParent(0);
+    p->setId(0);
+    graph->addVertexProperty(p);
+  }
+
+  if (flowGraph->hasDominance())
+  {
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("dominance", te::dt::DOUBLE_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addVertexProperty(p);
+  }
+
+  if (flowGraph->hasDominanceModes())
+  {//the order must follow the DominanceType values
+    const char* domProps[DOMINANCE_TYPE_COUNT] = { "dom_in", "dom_out", "dom_net", "dom_total" };
+
+    for (int t = 0; t < DOMINANCE_TYPE_COUNT; ++t)
+    {
+      te::dt::SimpleProperty* p = new te::dt::SimpleProperty(domProps[t], te::dt::DOUBLE_TYPE);
+      p->setParent(0);
+      p->setId(0);
+      graph->addVertexProperty(p);
+    }
+  }
+
+  std::vector<std::string> intProps;
+
+  if (flowGraph->hasMainFlow())
+  {
+    intProps.push_back("level");
+
+    if (flowGraph->hasMainFlowStatistics())
+    {
+      intProps.push_back("destiny");  // no superior imediato do no corrente
+      intProps.push_back("tree");     // quantos nohs possuem na rede deste root
+      intProps.push_back("input");    // quantos filhos este noh possue
+    }
+  }
+
+  for (std::size_t t = 0; t < intProps.size(); ++t)
+  {
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty(intProps[t], te::dt::INT32_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addVertexProperty(p);
+  }
+}
+
+void te::qt::plugins::fiocruz::FlowGraphConverter::buildEdgeProperties(te::graph::AbstractGraph* graph, FlowGraph* flowGraph)
+{
+  {//add from property to graph
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("from_id", te::dt::INT32_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  {//add from alias property to graph
+    te::dt::SimpleProperty* p = new te::dt::StringProperty("from_name");
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  {//add to property to graph
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("to_id", te::dt::INT32_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  {//add to alias property to graph
+    te::dt::SimpleProperty* p = new te::dt::StringProperty("to_name");
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  {//add weight property to graph
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("weight", te::dt::DOUBLE_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  {//add distance property to graph
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("distance", te::dt::DOUBLE_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  if (flowGraph->hasMainFlow())
+  {//add main flow property to graph
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("main_flow", te::dt::INT32_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  if (flowGraph->hasFlowRank())
+  {//add rank and share of the flow among the output flows of its origin
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("flow_rank", te::dt::INT32_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+
+    p = new te::dt::SimpleProperty("flow_share", te::dt::DOUBLE_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+
+  if (flowGraph->hasRecordCount())
+  {//add number of aggregated records property to graph
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("records", te::dt::INT32_TYPE);
+    p->setParent(0);
+    p->setId(0);
+    graph->addEdgeProperty(p);
+  }
+}
+
+int te::qt::plugins::fiocruz::FlowGraphConverter::getVertexAttrIdx(te::graph::AbstractGraph* graph, std::string attrName)
+{
+  int idx = -1;
+
+  for (int i = 0; i < graph->getVertexPropertySize(); ++i)
+  {
+    if (graph->getVertexProperty(i)->getName() == attrName)
+    {
+      idx = i;
+      break;
+    }
+  }
+
+  return idx;
+}
+
+int te::qt::plugins::fiocruz::FlowGraphConverter::getEdgeAttrIdx(te::graph::AbstractGraph* graph, std::string attrName)
+{
+  int idx = -1;
+
+  for (int i = 0; i < graph->getEdgePropertySize(); ++i)
+  {
+    if (graph->getEdgeProperty(i)->getName() == attrName)
+    {
+      idx = i;
+      break;
+    }
+  }
+
+  return idx;
+}
@@ -0,0 +1,99 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/FlowGraphConverter.h
+
+\brief This file defines the Flow Graph Converter class
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHCONVERTER_H
+#define __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHCONVERTER_H
+
+// TerraLib
+#include <terralib/graph/core/AbstractGraph.h>
+
+#include "../Config.h"
+#include "core/FlowGraph.h"
+
+// STL
+#include <memory>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \class FlowGraphConverter
+
+        \brief This class is used to convert a FlowGraph to/from a terralib graph.
+
+        It should only be used at the UI / export boundary, the flow algorithms
+        work directly over the FlowGraph columns.
+        */
+        class FlowGraphConverter
+        {
+
+          public:
+
+            FlowGraphConverter();
+
+            ~FlowGraphConverter();
+
+          public:
+
+            /*!
+            \brief Creates a bidirectional memory graph with all calculated columns of a flow graph.
+
+            \param graph  Input flow graph
+
+            \return A new terralib graph, the caller takes the ownership.
+            */
+            te::graph::AbstractGraph* toAbstractGraph(FlowGraph* graph);
+
+            /*!
+            \brief Creates a flow graph from a terralib graph with the flow attributes (name, coords, weight and distance).
+
+            \param graph  Input terralib graph
+
+            \return A new flow graph, the caller takes the ownership.
+            */
+            FlowGraph* fromAbstractGraph(te::graph::AbstractGraph* graph);
+
+          protected:
+
+            void buildVertexProperties(te::graph::AbstractGraph* graph, FlowGraph* flowGraph);
+
+            void buildEdgeProperties(te::graph::AbstractGraph* graph, FlowGraph* flowGraph);
+
+            int getVertexAttrIdx(te::graph::AbstractGraph* graph, std::string attrName);
+
+            int getEdgeAttrIdx(te::graph::AbstractGraph* graph, std::string attrName);
+
+        };
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHCONVERTER_H
@@ -26,25 +26,34 @@ TerraLib Team at <terralib-team@terralib.org>.
 //terralib
 #include <terralib/dataaccess/datasource/DataSource.h>
 #include <terralib/dataaccess/datasource/DataSourceFactory.h>
+#include <terralib/dataaccess/query/DataSetName.h>
+#include <terralib/dataaccess/query/Field.h>
+#include <terralib/dataaccess/query/FromItem.h>
+#include <terralib/dataaccess/query/Select.h>
 #include <terralib/datatype/SimpleData.h>
 #include <terralib/datatype/SimpleProperty.h>
 #include <terralib/datatype/StringProperty.h>
 #include <terralib/geometry/GeometryProperty.h>
-#include <terralib/geometry/MultiPolygon.h>
-#include <terralib/geometry/Polygon.h>
+#include <terralib/geometry/Point.h>
 #include <terralib/graph/core/AbstractGraphFactory.h>
 #include <terralib/graph/core/Edge.h>
 #include <terralib/graph/core/GraphMetadata.h>
 #include <terralib/graph/core/Vertex.h>
 
 
+#include "../CentroidCache.h"
+#include "../ColumnReader.h"
+#include "core/ParallelUtils.h"
 #include "FlowGraphDiagramBuilder.h"
+#include "PooledStringData.h"
 
 te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::FlowGraphDiagramBuilder()
 {
   m_graph.reset();
   m_errorMessage = "";
   m_edgeId = 0;
+  m_nameAttrIdx = 0;
+  m_distanceType = DISTANCE_PLANAR;
 }
 
 te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::~FlowGraphDiagramBuilder()
@@ -63,12 +72,12 @@ bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::build(te::da::DataSource
 
   m_graph->getMetadata()->setSRID(srid);
 
-  if (createVertexObjects(spatialDs, spatialDataSetName, linkColumnIdx, srid) == false)
+  if (createVertexObjects(spatialDs, spatialDataSetName, linkColumnIdx, linkColumnName, srid) == false)
   {
     return false;
   }
 
-  if (createEdgeObjects(tabularDs, tabularDataSetName, fromIdx, toIdx, weightIdx, linkColumnName) == false)
+  if (createEdgeObjects(tabularDs, tabularDataSetName, fromIdx, toIdx, weightIdx) == false)
   {
     return false;
   }
@@ -76,6 +85,11 @@ bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::build(te::da::DataSource
   return true;
 }
 
+void te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::setDistanceType(DistanceType type)
+{
+  m_distanceType = type;
+}
+
 std::string te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::getErrorMessage()
 {
   return m_errorMessage;
@@ -95,110 +109,109 @@ int  te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::getEdgeId()
   return id;
 }
 
-bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::createVertexObjects(te::da::DataSourcePtr spatialDs, const std::string& spatialDataSetName, const int& linkColumnIdx, const int& srid)
+bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::createVertexObjects(te::da::DataSourcePtr spatialDs, const std::string& spatialDataSetName, const int& linkColumnIdx, const int& linkColumnName, const int& srid)
 {
-  //get data set
-  std::auto_ptr<te::da::DataSet> dataSet = spatialDs->getDataSet(spatialDataSetName);
+  //get properties
+  boost::ptr_vector<te::dt::Property> properties = spatialDs->getProperties(spatialDataSetName);
 
-  if (dataSet.get() == 0)
+  if (properties.empty() || linkColumnIdx < 0 || linkColumnIdx >= (int)properties.size() || linkColumnName < 0 || linkColumnName >= (int)properties.size())
   {
     return false;
   }
 
-  //get properties
-  boost::ptr_vector<te::dt::Property> properties = spatialDs->getProperties(spatialDataSetName);
+  //only the link and name columns are read, the point comes from the centroid table
+  std::vector<te::dt::Property*> vertexProperties;
+  vertexProperties.push_back(&properties[linkColumnIdx]);
+
+  if (linkColumnName != linkColumnIdx)
+    vertexProperties.push_back(&properties[linkColumnName]);
+
+  m_nameAttrIdx = (int)vertexProperties.size() - 1;
+
+  te::da::Fields* fields = new te::da::Fields;
+
+  for (std::size_t i = 0; i < vertexProperties.size(); ++i)
+    fields->push_back(new te::da::Field(vertexProperties[i]->getName()));
+
+  te::da::FromItem* fromItem = new te::da::DataSetName(spatialDataSetName);
+  te::da::From* from = new te::da::From;
+  from->push_back(fromItem);
 
-  if (properties.empty())
+  te::da::Select select(fields);
+  select.setFrom(from);
+
+  //get data set
+  std::auto_ptr<te::da::DataSet> dataSet = spatialDs->query(select);
+
+  if (dataSet.get() == 0)
   {
     return false;
   }
 
   //create graph vertex attrs
-  boost::ptr_vector<te::dt::Property>::iterator it = properties.begin();
+  for (std::size_t i = 0; i < vertexProperties.size(); ++i)
+  {
+    te::dt::Property* p = vertexProperties[i]->clone();
+    p->setParent(0);
+    p->setId((unsigned int)i);
 
-  int count = 0;
+    m_graph->addVertexProperty(p);
+  }
 
-  while (it != properties.end())
-  {
-    te::dt::Property* p;
+  te::gm::GeometryProperty* gProp = new te::gm::GeometryProperty("coords");
+  gProp->setId((unsigned int)vertexProperties.size());
+  gProp->setGeometryType(te::gm::PointType);
+  gProp->setSRID(srid);
 
-    if (it->getType() == te::dt::GEOMETRY_TYPE)
-    {
-      //create graph attrs
-      te::gm::GeometryProperty* gProp = new te::gm::GeometryProperty("coords");
-      gProp->setId(0);
-      gProp->setGeometryType(te::gm::PointType);
-      gProp->setSRID(srid);
+  m_graph->addVertexProperty(gProp);
 
-      p = gProp;
-    }
-    else
-    {
-      p = it->clone();
-      p->setParent(0);
-      p->setId(count);
-    }
+  std::size_t attrCount = vertexProperties.size() + 1;
 
-    m_graph->addVertexProperty(p);
+  m_vertexIdx.clear();
+  m_vertices.clear();
+  m_vertexX.clear();
+  m_vertexY.clear();
+  m_vertexHasPoint.clear();
 
-    ++count;
+  //representative point of each object, computed once for each version of the data set
+  boost::shared_ptr<const CentroidTable> centroids = CentroidCache::getInstance().getTable(spatialDs, spatialDataSetName, properties[linkColumnIdx].getName());
 
-    ++it;
-  }
+  ColumnReader linkReader(dataSet.get(), (std::size_t)0);
 
   //create vertex objects
   while (dataSet->moveNext())
   {
-    int id = dataSet->getInt32(linkColumnIdx);
+    int id = linkReader.getId();
 
     te::graph::Vertex* v = new te::graph::Vertex(id);
 
-    v->setAttributeVecSize(properties.size());
+    v->setAttributeVecSize(attrCount);
+
+    for (std::size_t i = 0; i < vertexProperties.size(); ++i)
+      v->addAttribute((int)i, dataSet->getValue(i).release());
 
-    it = properties.begin();
+    //objects without a polygon or point geometry are not in the table and get no point
+    double x = 0.;
+    double y = 0.;
+
+    bool hasPoint = centroids->getPoint(linkReader.getString(), x, y);
+
+    if (hasPoint)
+      v->addAttribute((int)vertexProperties.size(), new te::gm::Point(x, y, srid));
+    else
+      v->addAttribute((int)vertexProperties.size(), 0);
 
-    count = 0;
+    //the edges get their vertices from the dictionary instead of the graph
+    bool added;
 
-    while (it != properties.end())
+    m_vertexIdx.add(id, added);
+
+    if (added)
     {
-      te::dt::AbstractData* ad = 0;
-
-      if (it->getType() == te::dt::GEOMETRY_TYPE)
-      {
-        te::gm::Geometry* g = dataSet->getGeometry(it->getName()).release();
-        g->setSRID(srid);
-
-        if (g->getGeomTypeId() == te::gm::PointType)
-        {
-          ad = g;
-        }
-        else if (g->getGeomTypeId() == te::gm::PolygonType)
-        {
-          te::gm::Point* p = ((te::gm::Polygon*)g)->getCentroid();
-          p->setSRID(srid);
-
-          ad = p;
-        }
-        else if (g->getGeomTypeId() == te::gm::MultiPolygonType)
-        {
-          te::gm::Polygon* poly = (te::gm::Polygon*)((te::gm::MultiPolygon*)g)->getGeometryN(0);
-
-          te::gm::Point* p = poly->getCentroid();
-          p->setSRID(srid);
-
-          ad = p;
-        }
-      }
-      else
-      {
-        ad = dataSet->getValue(it->getName()).release();
-      }
-
-      v->addAttribute(count, ad);
-
-      ++count;
-
-      ++it;
+      m_vertices.push_back(v);
+      m_vertexX.push_back(x);
+      m_vertexY.push_back(y);
+      m_vertexHasPoint.push_back(hasPoint ? 1 : 0);
     }
 
     m_graph->add(v);
@@ -207,7 +220,7 @@ bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::createVertexObjects(te::
   return true;
 }
 
-bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::createEdgeObjects(te::da::DataSourcePtr tabularDs, const std::string& tabularDataSetName, const int& fromIdx, const int& toIdx, const int& weightIdx, const int& linkColumnName)
+bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::createEdgeObjects(te::da::DataSourcePtr tabularDs, const std::string& tabularDataSetName, const int& fromIdx, const int& toIdx, const int& weightIdx)
 {
  
   {//add from property to graph
@@ -239,7 +252,7 @@ bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::createEdgeObjects(te::da
   }
 
   {//add weight property to graph
-    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("weight", te::dt::INT32_TYPE);
+    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("weight", te::dt::DOUBLE_TYPE);
     p->setParent(0);
     p->setId(0);
     m_graph->addEdgeProperty(p);
@@ -252,55 +265,103 @@ bool te::qt::plugins::fiocruz::FlowGraphDiagramBuilder::createEdgeObjects(te::da
     m_graph->addEdgeProperty(p);
   }
 
-  //vertex geom prop
-  int spatialPropertyId = -1;
-  getGraphVerterxAttrIndex(m_graph.get(), "coords", spatialPropertyId);
-
   //access tabular data set
   std::auto_ptr<te::da::DataSet> dataSet = tabularDs->getDataSet(tabularDataSetName);
 
   dataSet->moveBeforeFirst();
 
-  //create edges
+  //the column types are checked only once
+  ColumnReader fromReader(dataSet.get(), (std::size_t)fromIdx);
+  ColumnReader toReader(dataSet.get(), (std::size_t)toIdx);
+  ColumnReader weightReader(dataSet.get(), (std::size_t)weightIdx);
+
+  //read the flows whose vertices have a point, the coordinates are kept in separated arrays
+  std::vector<int> edgeIds;
+  std::vector<int> edgeFrom;
+  std::vector<int> edgeTo;
+  std::vector<double> edgeWeight;
+  std::vector<double> fromX;
+  std::vector<double> fromY;
+  std::vector<double> toX;
+  std::vector<double> toY;
+
   while (dataSet->moveNext())
   {
-    std::string fromStr = dataSet->getAsString(fromIdx);
-    std::string toStr = dataSet->getAsString(toIdx);
-    std::string weightStr = dataSet->getAsString(weightIdx);
+    int id = getEdgeId();
+    int from = fromReader.getId();
+    int to = toReader.getId();
+    double weight = weightReader.getDouble();
+
+    int vFromIdx = m_vertexIdx.getIndex(from);
+    int vToIdx = m_vertexIdx.getIndex(to);
+
+    if (vFromIdx == -1 || vToIdx == -1 || !m_vertexHasPoint[vFromIdx] || !m_vertexHasPoint[vToIdx])
+      continue;
+
+    edgeIds.push_back(id);
+    edgeFrom.push_back(vFromIdx);
+    edgeTo.push_back(vToIdx);
+    edgeWeight.push_back(weight);
+    fromX.push_back(m_vertexX[vFromIdx]);
+    fromY.push_back(m_vertexY[vFromIdx]);
+    toX.push_back(m_vertexX[vToIdx]);
+    toY.push_back(m_vertexY[vToIdx]);
+  }
+
+  dataSet.reset();
+
+  //calculate all distances at once, each thread runs the kernel over a slice of the edges
+  std::size_t nEdges = edgeIds.size();
+
+  std::vector<double> distance(nEdges);
+
+  DistanceType distanceType = m_distanceType;
+
+  ParallelFor(nEdges, 0, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    //a chunk may be empty (no edges), then &fromX[begin] would be out of range
+    if (begin == end)
+      return;
 
+    CalculateDistances(&fromX[begin], &fromY[begin], &toX[begin], &toY[begin], end - begin, distanceType, &distance[begin]);
+  });
 
-    int id = getEdgeId();
-    int from = atoi(fromStr.c_str());
-    int to = atoi(toStr.c_str());
-    int weight = atoi(weightStr.c_str());
+  //the vertex names are added to the pool on first use, each edge keeps only the handles
+  m_namePool.reset(new StringPool());
 
-    te::graph::Vertex* vFrom = m_graph->getVertex(from);
-    te::graph::Vertex* vTo = m_graph->getVertex(to);
+  std::vector<int> nameHandle(m_vertices.size(), -1);
 
-    if (vFrom && vTo)
-    {
-      te::gm::Point* pFrom = dynamic_cast<te::gm::Point*>(vFrom->getAttributes()[spatialPropertyId]);
-      te::gm::Point* pTo = dynamic_cast<te::gm::Point*>(vTo->getAttributes()[spatialPropertyId]);
+  //create edges
+  for (std::size_t i = 0; i < nEdges; ++i)
+  {
+    int vFromIdx = edgeFrom[i];
+    int vToIdx = edgeTo[i];
 
-      double distance = pFrom->distance(pTo);
-      std::string fromName = vFrom->getAttributes()[linkColumnName]->toString();
-      std::string toName = vTo->getAttributes()[linkColumnName]->toString();
+    te::graph::Vertex* vFrom = m_vertices[vFromIdx];
+    te::graph::Vertex* vTo = m_vertices[vToIdx];
 
+    if (nameHandle[vFromIdx] == -1)
+      nameHandle[vFromIdx] = (int)m_namePool->add(vFrom->getAttributes()[m_nameAttrIdx]->toString());
 
-      //create edge
-      te::graph::Edge* e = new te::graph::Edge(id, from, to);
+    if (nameHandle[vToIdx] == -1)
+      nameHandle[vToIdx] = (int)m_namePool->add(vTo->getAttributes()[m_nameAttrIdx]->toString());
 
-      e->setAttributeVecSize(6);
+    int from = vFrom->getId();
+    int to = vTo->getId();
 
-      e->addAttribute(0, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(from));
-      e->addAttribute(1, new te::dt::SimpleData<std::string, te::dt::STRING_TIME>(fromName));
-      e->addAttribute(2, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(to));
-      e->addAttribute(3, new te::dt::SimpleData<std::string, te::dt::STRING_TIME>(toName));
-      e->addAttribute(4, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(weight));
-      e->addAttribute(5, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(distance));
+    //create edge
+    te::graph::Edge* e = new te::graph::Edge(edgeIds[i], from, to);
 
-      m_graph->add(e);
-    }
+    e->setAttributeVecSize(6);
+
+    e->addAttribute(0, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(from));
+    e->addAttribute(1, new PooledStringData(m_namePool, nameHandle[vFromIdx]));
+    e->addAttribute(2, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(to));
+    e->addAttribute(3, new PooledStringData(m_namePool, nameHandle[vToIdx]));
+    e->addAttribute(4, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(edgeWeight[i]));
+    e->addAttribute(5, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(distance[i]));
+
+    m_graph->add(e);
   }
 
   return true;
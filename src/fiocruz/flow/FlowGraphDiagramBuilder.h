@@ -30,11 +30,15 @@ TerraLib Team at <terralib-team@terralib.org>.
 #include <terralib/graph/core/AbstractGraph.h>
 
 #include "../Config.h"
+#include "core/DistanceKernel.h"
+#include "core/IdDictionary.h"
+#include "core/StringPool.h"
 
 // STL
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 // BOOST Includes
 #include <boost/ptr_container/ptr_vector.hpp>
@@ -99,6 +103,9 @@ namespace te
             te::da::DataSourcePtr tabularDs, const std::string& tabularDataSetName, const int& fromIdx, const int& toIdx, const int& weightIdx,
             const std::map<std::string, std::string>& dsInfo, const std::string& graphType, const std::map<std::string, std::string>& gInfo);
 
+          /*! \brief Defines the metric of the edge distance attribute (default DISTANCE_PLANAR), the geodesic types expect lat/long vertices. */
+          void setDistanceType(DistanceType type);
+
           /*! \brief Get error message. */
           std::string getErrorMessage();
 
@@ -118,30 +125,38 @@ namespace te
           /*!
           \brief Function used to create all vertex object based on vectorial data
 
+          Only the link and alias columns are read from the data source, the vertex
+          point is taken from the CentroidCache, so the polygons are not loaded here.
+          The vertex attributes are the link column, the alias column (if it is not the
+          link column) and the "coords" point.
+
           \param spatialDs            Data Source wiht vectorial data
           \param spatialDataSetName   Data set name wiht vectorial data
           \param linkColumnIdx        Column index from vectorial data used as link column
+          \param linkColumnName       Column index from vectorial data used as alias column
           \param srid                 Vectorial projection id
 
           \return True if the vertexs was created correctly and false in othe case
 
           */
-          bool createVertexObjects(te::da::DataSourcePtr spatialDs, const std::string& spatialDataSetName, const int& linkColumnIdx, const int& srid);
+          bool createVertexObjects(te::da::DataSourcePtr spatialDs, const std::string& spatialDataSetName, const int& linkColumnIdx, const int& linkColumnName, const int& srid);
 
           /*!
           \brief Function used to create all edges object based on flow table data
 
+          The flows are read first and their distances are calculated in a single
+          batch (see CalculateDistances) before the edge objects are created.
+
           \param tabularDs            Data Source wiht tabular data
           \param tabularDataSetName   Data set name wiht tabular data
           \param fromIdx              Index for column table with origin information.
           \param toIdx                Index for column table with destiny information.
           \param weightIdx            Index for column table with weight information.
-          \param linkColumnName       Column index from vectorial data used as alias column
 
           \return True if the edges was created correctly and false in othe case
 
           */
-          bool createEdgeObjects(te::da::DataSourcePtr tabularDs, const std::string& tabularDataSetName, const int& fromIdx, const int& toIdx, const int& weightIdx, const int& linkColumnName);
+          bool createEdgeObjects(te::da::DataSourcePtr tabularDs, const std::string& tabularDataSetName, const int& fromIdx, const int& toIdx, const int& weightIdx);
 
           bool getGraphVerterxAttrIndex(te::graph::AbstractGraph* graph, std::string attrName, int& index);
 
@@ -153,6 +168,22 @@ namespace te
 
           int m_edgeId;  //!< Attribute used as a index counter for edge objects
 
+          int m_nameAttrIdx;                                     //!< Position of the alias column in the vertex attributes
+
+          IdDictionary<int> m_vertexIdx;                         //!< Vertex id to position in m_vertices
+
+          std::vector<te::graph::Vertex*> m_vertices;            //!< Vertex objects in creation order (owned by the graph)
+
+          std::vector<double> m_vertexX;                         //!< Point x coordinate of each vertex in m_vertices
+
+          std::vector<double> m_vertexY;                         //!< Point y coordinate of each vertex in m_vertices
+
+          std::vector<unsigned char> m_vertexHasPoint;           //!< Flag of the vertices in m_vertices with a point
+
+          DistanceType m_distanceType;                           //!< Metric of the edge distance attribute
+
+          boost::shared_ptr<StringPool> m_namePool;              //!< Vertex names shared by the edge name attributes
+
         };
       }   // end namespace fiocruz
     }     // end namespace plugins
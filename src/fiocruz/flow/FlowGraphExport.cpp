@@ -24,9 +24,14 @@ TerraLib Team at <terralib-team@terralib.org>.
 */
 
 //terralib
+#include <terralib/common/Exception.h>
+#include <terralib/common/Translator.h>
+#include <terralib/dataaccess/datasource/DataSourceTransactor.h>
 #include <terralib/datatype/SimpleProperty.h>
+#include <terralib/datatype/StringProperty.h>
 #include <terralib/geometry/GeometryProperty.h>
 #include <terralib/geometry/LineString.h>
+#include <terralib/geometry/Point.h>
 #include <terralib/graph/core/AbstractGraph.h>
 #include <terralib/graph/core/GraphMetadata.h>
 #include <terralib/graph/core/Edge.h>
@@ -38,9 +43,27 @@ TerraLib Team at <terralib-team@terralib.org>.
 
 #include "FlowGraphExport.h"
 
-te::qt::plugins::fiocruz::FlowGraphExport::FlowGraphExport()
+// STL
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <thread>
+
+namespace
 {
+  void AddProperty(te::da::DataSetType* dsType, const std::string& name, int type)
+  {
+    te::dt::SimpleProperty* p = (type == te::dt::STRING_TYPE) ? new te::dt::StringProperty(name) : new te::dt::SimpleProperty(name, type);
+    p->setParent(0);
+    p->setId(0);
 
+    dsType->add(p);
+  }
+}
+
+te::qt::plugins::fiocruz::FlowGraphExport::FlowGraphExport()
+{
+  m_batchSize = 10000;
 }
 
 te::qt::plugins::fiocruz::FlowGraphExport::~FlowGraphExport()
@@ -82,6 +105,129 @@ void te::qt::plugins::fiocruz::FlowGraphExport::exportGraph(te::da::DataSourcePt
   }
 }
 
+void te::qt::plugins::fiocruz::FlowGraphExport::exportGraph(te::da::DataSourcePtr ds, std::string dataSetName, FlowGraph* graph, FlowGraphExportType exportType)
+{
+  assert(graph);
+
+  std::auto_ptr<te::da::DataSetType> dsType;
+
+  std::size_t rowCount = 0;
+
+  if (exportType == FLOWGRAPH_EDGE_TYPE)
+  {
+    dsType = createEdgeDataSetType(dataSetName, graph);
+    rowCount = graph->getEdgeCount();
+  }
+  else if (exportType == FLOWGRAPH_VERTEX_TYPE)
+  {
+    dsType = createVertexDataSetType(dataSetName, graph);
+    rowCount = graph->getVertexCount();
+  }
+  else
+  {
+    throw te::common::Exception(TE_TR("Invalid flow graph export type."));
+  }
+
+  std::map<std::string, std::string> options;
+
+  std::auto_ptr<te::da::DataSourceTransactor> transactor = ds->getTransactor();
+
+  try
+  {
+    transactor->begin();
+
+    transactor->createDataSet(dsType.get(), options);
+
+    //only one batch of rows is kept in memory
+    te::mem::DataSet batch(dsType.get());
+
+    std::size_t batchSize = std::max<std::size_t>(m_batchSize, 1);
+
+    for (std::size_t begin = 0; begin < rowCount; begin += batchSize)
+    {
+      std::size_t end = std::min(rowCount, begin + batchSize);
+
+      for (std::size_t row = begin; row < end; ++row)
+      {
+        te::mem::DataSetItem* item = new te::mem::DataSetItem(&batch);
+
+        if (exportType == FLOWGRAPH_EDGE_TYPE)
+          setEdgeItem(graph, row, item);
+        else
+          setVertexItem(graph, row, item);
+
+        batch.add(item);
+      }
+
+      batch.moveBeforeFirst();
+
+      transactor->add(dataSetName, &batch, options);
+
+      batch.clear();
+    }
+
+    transactor->commit();
+  }
+  catch (...)
+  {
+    if (transactor->isInTransaction())
+      transactor->rollBack();
+
+    throw;
+  }
+}
+
+void te::qt::plugins::fiocruz::FlowGraphExport::exportGraph(te::da::DataSourcePtr edgeDs, std::string edgeDataSetName, te::da::DataSourcePtr vertexDs, std::string vertexDataSetName, FlowGraph* graph)
+{
+  assert(graph);
+
+  //a data source object is not shared between threads
+  if (edgeDs.get() == vertexDs.get())
+  {
+    exportGraph(edgeDs, edgeDataSetName, graph, FLOWGRAPH_EDGE_TYPE);
+    exportGraph(vertexDs, vertexDataSetName, graph, FLOWGRAPH_VERTEX_TYPE);
+    return;
+  }
+
+  std::exception_ptr vertexError;
+
+  std::thread vertexWorker([&]()
+  {
+    try
+    {
+      exportGraph(vertexDs, vertexDataSetName, graph, FLOWGRAPH_VERTEX_TYPE);
+    }
+    catch (...)
+    {
+      vertexError = std::current_exception();
+    }
+  });
+
+  std::exception_ptr edgeError;
+
+  try
+  {
+    exportGraph(edgeDs, edgeDataSetName, graph, FLOWGRAPH_EDGE_TYPE);
+  }
+  catch (...)
+  {
+    edgeError = std::current_exception();
+  }
+
+  vertexWorker.join();
+
+  if (edgeError)
+    std::rethrow_exception(edgeError);
+
+  if (vertexError)
+    std::rethrow_exception(vertexError);
+}
+
+void te::qt::plugins::fiocruz::FlowGraphExport::setBatchSize(std::size_t batchSize)
+{
+  m_batchSize = batchSize;
+}
+
 std::auto_ptr<te::da::DataSetType> te::qt::plugins::fiocruz::FlowGraphExport::createEdgeDataSetType(std::string dataSetName, te::graph::AbstractGraph* graph)
 {
   std::auto_ptr<te::da::DataSetType> dataSetType(new te::da::DataSetType(dataSetName));
@@ -253,6 +399,175 @@ std::auto_ptr<te::mem::DataSet> te::qt::plugins::fiocruz::FlowGraphExport::creat
   return outDataset;
 }
 
+std::auto_ptr<te::da::DataSetType> te::qt::plugins::fiocruz::FlowGraphExport::createEdgeDataSetType(std::string dataSetName, FlowGraph* graph)
+{
+  std::auto_ptr<te::da::DataSetType> dataSetType(new te::da::DataSetType(dataSetName));
+
+  //same columns of the edges created by FlowGraphConverter
+  AddProperty(dataSetType.get(), "index", te::dt::INT32_TYPE);
+  AddProperty(dataSetType.get(), "from_id", te::dt::INT32_TYPE);
+  AddProperty(dataSetType.get(), "from_name", te::dt::STRING_TYPE);
+  AddProperty(dataSetType.get(), "to_id", te::dt::INT32_TYPE);
+  AddProperty(dataSetType.get(), "to_name", te::dt::STRING_TYPE);
+  AddProperty(dataSetType.get(), "weight", te::dt::DOUBLE_TYPE);
+  AddProperty(dataSetType.get(), "distance", te::dt::DOUBLE_TYPE);
+
+  if (graph->hasMainFlow())
+    AddProperty(dataSetType.get(), "main_flow", te::dt::INT32_TYPE);
+
+  if (graph->hasFlowRank())
+  {
+    AddProperty(dataSetType.get(), "flow_rank", te::dt::INT32_TYPE);
+    AddProperty(dataSetType.get(), "flow_share", te::dt::DOUBLE_TYPE);
+  }
+
+  if (graph->hasRecordCount())
+    AddProperty(dataSetType.get(), "records", te::dt::INT32_TYPE);
+
+  //create geometry prop
+  te::gm::GeometryProperty* geomProp = new te::gm::GeometryProperty("line", graph->getSRID(), te::gm::LineStringType, true);
+  dataSetType->add(geomProp);
+
+  return dataSetType;
+}
+
+std::auto_ptr<te::da::DataSetType> te::qt::plugins::fiocruz::FlowGraphExport::createVertexDataSetType(std::string dataSetName, FlowGraph* graph)
+{
+  std::auto_ptr<te::da::DataSetType> dataSetType(new te::da::DataSetType(dataSetName));
+
+  //same columns of the vertices created by FlowGraphConverter
+  AddProperty(dataSetType.get(), "index", te::dt::INT32_TYPE);
+  AddProperty(dataSetType.get(), "name", te::dt::STRING_TYPE);
+
+  te::gm::GeometryProperty* geomProp = new te::gm::GeometryProperty("coords", graph->getSRID(), te::gm::PointType);
+  dataSetType->add(geomProp);
+
+  if (graph->hasStatistics())
+  {
+    AddProperty(dataSetType.get(), "in_flows", te::dt::INT32_TYPE);
+    AddProperty(dataSetType.get(), "out_flows", te::dt::INT32_TYPE);
+    AddProperty(dataSetType.get(), "sum_in", te::dt::DOUBLE_TYPE);
+    AddProperty(dataSetType.get(), "sum_out", te::dt::DOUBLE_TYPE);
+
+    if (graph->hasExtendedStatistics())
+    {
+      AddProperty(dataSetType.get(), "mean_in", te::dt::DOUBLE_TYPE);
+      AddProperty(dataSetType.get(), "mean_out", te::dt::DOUBLE_TYPE);
+      AddProperty(dataSetType.get(), "max_in", te::dt::DOUBLE_TYPE);
+      AddProperty(dataSetType.get(), "max_out", te::dt::DOUBLE_TYPE);
+    }
+  }
+
+  if (graph->hasDominance())
+    AddProperty(dataSetType.get(), "dominance", te::dt::DOUBLE_TYPE);
+
+  if (graph->hasDominanceModes())
+  {//the order must follow the DominanceType values
+    const char* domProps[DOMINANCE_TYPE_COUNT] = { "dom_in", "dom_out", "dom_net", "dom_total" };
+
+    for (int t = 0; t < DOMINANCE_TYPE_COUNT; ++t)
+      AddProperty(dataSetType.get(), domProps[t], te::dt::DOUBLE_TYPE);
+  }
+
+  if (graph->hasMainFlow())
+  {
+    AddProperty(dataSetType.get(), "level", te::dt::INT32_TYPE);
+
+    if (graph->hasMainFlowStatistics())
+    {
+      AddProperty(dataSetType.get(), "destiny", te::dt::INT32_TYPE);
+      AddProperty(dataSetType.get(), "tree", te::dt::INT32_TYPE);
+      AddProperty(dataSetType.get(), "input", te::dt::INT32_TYPE);
+    }
+  }
+
+  return dataSetType;
+}
+
+void te::qt::plugins::fiocruz::FlowGraphExport::setEdgeItem(FlowGraph* graph, std::size_t e, te::mem::DataSetItem* item)
+{
+  const std::vector<int>& ids = graph->getVertexIds();
+  const std::vector<double>& xs = graph->getVertexX();
+  const std::vector<double>& ys = graph->getVertexY();
+
+  int from = graph->getEdgeFrom()[e];
+  int to = graph->getEdgeTo()[e];
+
+  std::size_t idx = 0;
+
+  item->setInt32(idx++, (int)e);
+  item->setInt32(idx++, ids[from]);
+  item->setString(idx++, graph->getVertexName(from));
+  item->setInt32(idx++, ids[to]);
+  item->setString(idx++, graph->getVertexName(to));
+  item->setDouble(idx++, graph->getWeight()[e]);
+  item->setDouble(idx++, graph->getDistance()[e]);
+
+  if (graph->hasMainFlow())
+    item->setInt32(idx++, graph->getMainFlow()[e]);
+
+  if (graph->hasFlowRank())
+  {
+    item->setInt32(idx++, graph->getFlowRank()[e]);
+    item->setDouble(idx++, graph->getFlowShare()[e]);
+  }
+
+  if (graph->hasRecordCount())
+    item->setInt32(idx++, graph->getRecordCount()[e]);
+
+  te::gm::LineString* line = new te::gm::LineString(2, te::gm::LineStringType, graph->getSRID());
+  line->setPoint(0, xs[from], ys[from]);
+  line->setPoint(1, xs[to], ys[to]);
+
+  item->setGeometry(idx++, line);
+}
+
+void te::qt::plugins::fiocruz::FlowGraphExport::setVertexItem(FlowGraph* graph, std::size_t v, te::mem::DataSetItem* item)
+{
+  std::size_t idx = 0;
+
+  item->setInt32(idx++, graph->getVertexIds()[v]);
+  item->setString(idx++, graph->getVertexName(v));
+  item->setGeometry(idx++, new te::gm::Point(graph->getVertexX()[v], graph->getVertexY()[v], graph->getSRID()));
+
+  if (graph->hasStatistics())
+  {
+    item->setInt32(idx++, graph->getInFlows()[v]);
+    item->setInt32(idx++, graph->getOutFlows()[v]);
+    item->setDouble(idx++, graph->getSumIn()[v]);
+    item->setDouble(idx++, graph->getSumOut()[v]);
+
+    if (graph->hasExtendedStatistics())
+    {
+      item->setDouble(idx++, graph->getMeanIn()[v]);
+      item->setDouble(idx++, graph->getMeanOut()[v]);
+      item->setDouble(idx++, graph->getMaxIn()[v]);
+      item->setDouble(idx++, graph->getMaxOut()[v]);
+    }
+  }
+
+  if (graph->hasDominance())
+    item->setDouble(idx++, graph->getDominance()[v]);
+
+  if (graph->hasDominanceModes())
+  {
+    for (int t = 0; t < DOMINANCE_TYPE_COUNT; ++t)
+      item->setDouble(idx++, graph->getDominance((DominanceType)t)[v]);
+  }
+
+  if (graph->hasMainFlow())
+  {
+    item->setInt32(idx++, graph->getLevel()[v]);
+
+    if (graph->hasMainFlowStatistics())
+    {
+      item->setInt32(idx++, graph->getDestiny()[v]);
+      item->setInt32(idx++, graph->getTree()[v]);
+      item->setInt32(idx++, graph->getInput()[v]);
+    }
+  }
+}
+
 std::map<int, std::string> te::qt::plugins::fiocruz::FlowGraphExport::getEdgePropertyMap(te::graph::AbstractGraph* graph)
 {
   std::map<int, std::string> propMap;
@@ -30,8 +30,10 @@ TerraLib Team at <terralib-team@terralib.org>.
 #include <terralib/dataaccess/datasource/DataSource.h>
 #include <terralib/graph/core/AbstractGraph.h>
 #include <terralib/memory/DataSet.h>
+#include <terralib/memory/DataSetItem.h>
 
 #include "../Config.h"
+#include "core/FlowGraph.h"
 
 // STL
 #include <memory>
@@ -68,8 +70,42 @@ namespace te
 
             void exportGraph(te::da::DataSourcePtr ds, std::string dataSetName, te::graph::AbstractGraph* graph, FlowGraphExportType exportType);
 
+            /*!
+            \brief Exports the edges or the vertices of a flow graph, the rows are written in batches.
+
+            The rows are created directly from the graph columns, only one batch of m_batchSize
+            rows is kept in memory. The data set is created and filled inside a transaction,
+            it is rolled back if a batch fails.
+
+            \exception te::common::Exception It throws an exception if the export type is invalid.
+            */
+            void exportGraph(te::da::DataSourcePtr ds, std::string dataSetName, FlowGraph* graph, FlowGraphExportType exportType);
+
+            /*!
+            \brief Exports the edges and the vertices of a flow graph at the same time.
+
+            The vertices are written by a worker thread and the edges by the calling thread,
+            each one with its own data source transaction, the graph is only read. If both
+            data sets go to the same data source object, they are written one after the other.
+            The first error found (edges first) is thrown after both writes finish.
+            */
+            void exportGraph(te::da::DataSourcePtr edgeDs, std::string edgeDataSetName, te::da::DataSourcePtr vertexDs, std::string vertexDataSetName, FlowGraph* graph);
+
+            /*! \brief Defines the number of rows written to the data source at once (default 10000). */
+            void setBatchSize(std::size_t batchSize);
+
           protected:
 
+            std::auto_ptr<te::da::DataSetType> createEdgeDataSetType(std::string dataSetName, FlowGraph* graph);
+
+            std::auto_ptr<te::da::DataSetType> createVertexDataSetType(std::string dataSetName, FlowGraph* graph);
+
+            /*! \brief Sets the values of an edge row, in the order of createEdgeDataSetType. */
+            void setEdgeItem(FlowGraph* graph, std::size_t e, te::mem::DataSetItem* item);
+
+            /*! \brief Sets the values of a vertex row, in the order of createVertexDataSetType. */
+            void setVertexItem(FlowGraph* graph, std::size_t v, te::mem::DataSetItem* item);
+
             std::auto_ptr<te::da::DataSetType> createEdgeDataSetType(std::string dataSetName, te::graph::AbstractGraph* graph);
 
             std::auto_ptr<te::da::DataSetType> createVertexDataSetType(std::string dataSetName, te::graph::AbstractGraph* graph);
@@ -84,6 +120,10 @@ namespace te
 
             bool getGraphVerterxAttrIndex(te::graph::AbstractGraph* graph, std::string attrName, int& index);
 
+          protected:
+
+            std::size_t m_batchSize;    //!< Number of rows written at once by the flow graph export
+
         };
       }   // end namespace fiocruz
     }     // end namespace plugins
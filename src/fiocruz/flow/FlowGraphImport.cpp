@@ -24,27 +24,43 @@ TerraLib Team at <terralib-team@terralib.org>.
 */
 
 
+#include "../CentroidCache.h"
 #include "FlowGraphImport.h"
+#include "core/DistanceKernel.h"
+#include "core/ParallelUtils.h"
 
 //terralib
+#include <terralib/common/Exception.h>
+#include <terralib/common/Translator.h>
 #include <terralib/dataaccess/utils/Utils.h>
-#include <terralib/datatype/SimpleData.h>
-#include <terralib/datatype/SimpleProperty.h>
-#include <terralib/datatype/StringProperty.h>
-#include <terralib/geometry/GeometryProperty.h>
 #include <terralib/geometry/MultiLineString.h>
-#include <terralib/graph/Globals.h>
-#include <terralib/graph/core/AbstractGraph.h>
-#include <terralib/graph/core/AbstractGraphFactory.h>
-#include <terralib/graph/core/GraphMetadata.h>
-#include <terralib/graph/core/Edge.h>
-#include <terralib/graph/core/Vertex.h>
-#include <terralib/graph/iterator/MemoryIterator.h>
+#include <terralib/geometry/MultiPolygon.h>
+#include <terralib/geometry/Point.h>
+#include <terralib/geometry/Polygon.h>
 
+// STL
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace
+{
+  //origin / destiny pair as a single key, used to find the edge of a pair while appending
+  boost::int64_t MakePairKey(int from, int to)
+  {
+    return ((boost::int64_t)from << 32) | (boost::uint32_t)to;
+  }
+}
 
 te::qt::plugins::fiocruz::FlowGraphImport::FlowGraphImport()
 {
-  m_edgeId = 0;
+  m_numThreads = 1;
+  m_batchSize = 65536;
+  m_aggregatePairs = false;
+  m_maxPairs = 4194304;
+  m_extendedStatistics = false;
+  m_appending = false;
+  m_distanceType = DISTANCE_PLANAR;
 }
 
 te::qt::plugins::fiocruz::FlowGraphImport::~FlowGraphImport()
@@ -52,277 +68,670 @@ te::qt::plugins::fiocruz::FlowGraphImport::~FlowGraphImport()
 
 }
 
-te::graph::AbstractGraph* te::qt::plugins::fiocruz::FlowGraphImport::importGraph(std::auto_ptr<te::da::DataSet> dataSet, int geomidx, bool addStatisticsColumns)
+te::qt::plugins::fiocruz::FlowGraph* te::qt::plugins::fiocruz::FlowGraphImport::importGraph(std::auto_ptr<te::da::DataSet> dataSet, int geomidx, bool addStatisticsColumns)
+{
+  std::auto_ptr<FlowGraph> graph(new FlowGraph());
+
+  m_aggregator.reset(m_aggregatePairs ? new FlowPairAggregator(m_maxPairs) : 0);
+
+  bool hasSRID = false;
+
+  readFlows(graph.get(), dataSet.get(), geomidx, hasSRID);
+
+  if (m_aggregatePairs)
+    addAggregatedEdges(graph.get());
+
+  graph->build();
+
+  //without a distance column the distances are calculated from the vertex coordinates
+  if (!m_distance.isValid())
+    CalculateDistances(graph.get(), m_distanceType, m_numThreads);
+
+  if (addStatisticsColumns)
+    calculateStatistics(graph.get());
+
+  return graph.release();
+}
+
+std::vector<int> te::qt::plugins::fiocruz::FlowGraphImport::appendGraph(FlowGraph* graph, std::auto_ptr<te::da::DataSet> dataSet, int geomidx)
 {
-  te::graph::AbstractGraph* graph = buildGraph(addStatisticsColumns);
+  assert(graph);
+
+  //the existing pairs are indexed, a delta row with a known pair is added to its edge
+  const std::vector<int>& from = graph->getEdgeFrom();
+  const std::vector<int>& to = graph->getEdgeTo();
+
+  m_aggregator.reset();
+  m_appending = true;
+  m_pairIndex.clear();
+  m_pairIndex.reserve(graph->getEdgeCount());
+  m_pairEdge.clear();
+  m_changed.assign(graph->getVertexCount(), 0);
+
+  for (std::size_t e = 0; e < graph->getEdgeCount(); ++e)
+  {
+    bool added;
 
-  int originIdx = te::da::GetPropertyIndex(dataSet.get(), "from_id");
-  int originNameIdx = te::da::GetPropertyIndex(dataSet.get(), "from_name");
-  int destinyIdx = te::da::GetPropertyIndex(dataSet.get(), "to_id");
-  int destinyNameIdx = te::da::GetPropertyIndex(dataSet.get(), "to_name");
-  int weightIdx = te::da::GetPropertyIndex(dataSet.get(), "weight");
-  int distIdx = te::da::GetPropertyIndex(dataSet.get(), "distance");
+    m_pairIndex.add(MakePairKey(from[e], to[e]), added);
+
+    //with parallel edges, the first one receives the new records
+    if (added)
+      m_pairEdge.push_back((int)e);
+  }
+
+  bool hasSRID = true;
+
+  std::size_t firstNewEdge = graph->getEdgeCount();
+
+  try
+  {
+    readFlows(graph, dataSet.get(), geomidx, hasSRID);
+  }
+  catch (...)
+  {
+    m_appending = false;
+    throw;
+  }
+
+  m_appending = false;
+  m_pairIndex.clear();
+  m_pairEdge.clear();
+
+  graph->build();
+
+  //only the new edges get a distance, the existing pairs keep theirs
+  if (!m_distance.isValid())
+    CalculateDistances(graph, m_distanceType, m_numThreads, firstNewEdge);
+
+  std::vector<int> changed;
+
+  for (std::size_t v = 0; v < m_changed.size(); ++v)
+  {
+    if (m_changed[v])
+      changed.push_back((int)v);
+  }
+
+  m_changed.clear();
+
+  if (graph->hasStatistics())
+    updateStatistics(graph, changed);
+
+  return changed;
+}
+
+void te::qt::plugins::fiocruz::FlowGraphImport::readFlows(FlowGraph* graph, te::da::DataSet* dataSet, int geomidx, bool& hasSRID)
+{
+  m_origin = ColumnReader(dataSet, "from_id");
+  m_originName = ColumnReader(dataSet, "from_name");
+  m_destiny = ColumnReader(dataSet, "to_id");
+  m_destinyName = ColumnReader(dataSet, "to_name");
+  m_weight = ColumnReader(dataSet, "weight");
+  m_distance = ColumnReader(dataSet, "distance");
+
+  m_geomCount = 0;
+  m_geomErrorCount = 0;
+
+  std::size_t numThreads = GetThreadCount(m_numThreads);
+
+  //two batches are used: the workers parse one while the next is read from the data set
+  std::vector<Row> batches[2];
+  std::vector<ParsedEdgeBuffer> buffers(numThreads);
+
+  std::size_t cur = 0;
 
   //fill graph
   dataSet->moveBeforeFirst();
 
-  while (dataSet->moveNext())
+  std::size_t nRows = readBatch(dataSet, geomidx, batches[cur]);
+
+  while (nRows > 0)
   {
-    std::string originId = dataSet->getAsString(originIdx);
-    std::string originName = dataSet->getAsString(originNameIdx);
-    std::string destinyId = dataSet->getAsString(destinyIdx);
-    std::string destinyName = dataSet->getAsString(destinyNameIdx);
-    std::string weightStr = dataSet->getAsString(weightIdx);
-    std::string distStr = dataSet->getAsString(distIdx);
+    std::vector<Row>& rows = batches[cur];
 
-    //get geometry from edge (lineString with 2 coords)
-    std::auto_ptr<te::gm::Geometry> geom = dataSet->getGeometry(geomidx);
-    te::gm::LineString* line = getLine(geom.get());
+    for (std::size_t t = 0; t < buffers.size(); ++t)
+      buffers[t].clear();
+
+    std::size_t nextRows = 0;
 
-    if (line)
+    if (numThreads <= 1)
     {
-      //check if graph has the origin vertex
-      te::graph::Vertex* vFrom = graph->getVertex(atoi(originId.c_str()));
+      parseRows(rows, 0, nRows, buffers[0]);
+
+      mergeEdges(graph, rows, buffers[0], hasSRID);
+
+      nRows = readBatch(dataSet, geomidx, rows);
+
+      continue;
+    }
 
-      if (!vFrom)
+    //each worker parses a contiguous range of rows into its own buffer
+    std::thread parser([&]()
+    {
+      ParallelFor(nRows, numThreads, [&](std::size_t begin, std::size_t end, std::size_t t)
       {
-        //create vertex
-        vFrom = new te::graph::Vertex(atoi(originId.c_str()));
-        vFrom->setAttributeVecSize(2); 
+        parseRows(rows, begin, end, buffers[t]);
+      });
+    });
 
-        vFrom->addAttribute(0, new te::dt::SimpleData<std::string, te::dt::STRING_TIME>(originName));
-        vFrom->addAttribute(1, new te::gm::Point(*line->getPointN(0)));
+    try
+    {
+      nextRows = readBatch(dataSet, geomidx, batches[1 - cur]);
+    }
+    catch (...)
+    {
+      parser.join();
+      throw;
+    }
 
-        //add to graph
-        graph->add(vFrom);
-      }
+    parser.join();
 
-      //check if graph has the destiny vertex
-      te::graph::Vertex* vTo = graph->getVertex(atoi(destinyId.c_str()));
+    //the buffers are merged in thread order, so the edge ids are the same of a serial import
+    for (std::size_t t = 0; t < buffers.size(); ++t)
+      mergeEdges(graph, rows, buffers[t], hasSRID);
 
-      if (!vTo)
-      {
-        //create vertex
-        vTo = new te::graph::Vertex(atoi(destinyId.c_str()));
-        vTo->setAttributeVecSize(2);
+    cur = 1 - cur;
+    nRows = nextRows;
+  }
 
-        vTo->addAttribute(0, new te::dt::SimpleData<std::string, te::dt::STRING_TIME>(destinyName));
-        vTo->addAttribute(1, new te::gm::Point(*line->getPointN(1)));
+  //a driver that can not decode any geometry would give an empty graph without notice
+  if (m_geomCount > 0 && m_geomErrorCount == m_geomCount)
+    throw te::common::Exception(TE_TR("None of the flow geometries could be read."));
+}
 
-        //add to graph
-        graph->add(vTo);
-      }
+te::qt::plugins::fiocruz::FlowGraph* te::qt::plugins::fiocruz::FlowGraphImport::importGraph(std::auto_ptr<te::da::DataSet> flowDataSet, std::auto_ptr<te::da::DataSet> vertexDataSet,
+                                                                                             const std::string& vertexIdColumn, const std::string& vertexNameColumn, bool addStatisticsColumns)
+{
+  std::auto_ptr<FlowGraph> graph(new FlowGraph());
 
-      //create edge
-      if (vFrom && vTo)
-      {
-        int id = getEdgeId();
+  //vertex table, each vertex geometry is decoded only once
+  std::vector<VertexRow> vertices;
+  IdDictionary<int> vertexRowIdx;
 
-        te::graph::Edge* e = new te::graph::Edge(id, vFrom->getId(), vTo->getId());
+  graph->setSRID(readVertices(vertexDataSet.get(), vertexIdColumn, vertexNameColumn, vertices, vertexRowIdx));
 
-        e->setAttributeVecSize(6);
+  vertexDataSet.reset();
 
-        e->addAttribute(0, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(vFrom->getId()));
-        e->addAttribute(1, new te::dt::SimpleData<std::string, te::dt::STRING_TIME>(originName));
-        e->addAttribute(2, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(vTo->getId()));
-        e->addAttribute(3, new te::dt::SimpleData<std::string, te::dt::STRING_TIME>(destinyName));
-        e->addAttribute(4, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(atoi(weightStr.c_str())));
-        e->addAttribute(5, new te::dt::SimpleData<double, te::dt::DOUBLE_TYPE>(atof(distStr.c_str())));
+  //flow table, only the id and value columns are read
+  m_origin = ColumnReader(flowDataSet.get(), "from_id");
+  m_destiny = ColumnReader(flowDataSet.get(), "to_id");
+  m_weight = ColumnReader(flowDataSet.get(), "weight");
+  m_distance = ColumnReader(flowDataSet.get(), "distance");
 
-        graph->add(e);
-      }
-    }
+  if (!m_origin.isValid() || !m_destiny.isValid() || !m_weight.isValid())
+    throw te::common::Exception(TE_TR("Flow data set must have the from_id, to_id and weight columns."));
+
+  m_aggregator.reset(m_aggregatePairs ? new FlowPairAggregator(m_maxPairs) : 0);
+
+  flowDataSet->moveBeforeFirst();
+
+  while (flowDataSet->moveNext())
+  {
+    int vFrom = getVertex(graph.get(), m_origin.getId(), vertices, vertexRowIdx);
+    int vTo = getVertex(graph.get(), m_destiny.getId(), vertices, vertexRowIdx);
+
+    if (vFrom == -1 || vTo == -1)
+      continue;
+
+    double distance = m_distance.isValid() ? m_distance.getDouble() : 0.;
+
+    addFlow(graph.get(), vFrom, vTo, m_weight.getDouble(), distance);
   }
 
+  if (m_aggregatePairs)
+    addAggregatedEdges(graph.get());
+
+  graph->build();
+
+  //without a distance column the distances are calculated from the vertex coordinates
+  if (!m_distance.isValid())
+    CalculateDistances(graph.get(), m_distanceType, m_numThreads);
+
   if (addStatisticsColumns)
-    calculateStatistics(graph);
+    calculateStatistics(graph.get());
+
+  return graph.release();
+}
+
+void te::qt::plugins::fiocruz::FlowGraphImport::setNumberOfThreads(std::size_t numThreads)
+{
+  m_numThreads = numThreads;
+}
+
+void te::qt::plugins::fiocruz::FlowGraphImport::setBatchSize(std::size_t batchSize)
+{
+  m_batchSize = batchSize > 0 ? batchSize : 1;
+}
+
+void te::qt::plugins::fiocruz::FlowGraphImport::setAggregatePairs(bool aggregate, std::size_t maxPairs)
+{
+  m_aggregatePairs = aggregate;
+  m_maxPairs = maxPairs > 0 ? maxPairs : 1;
+}
 
-  return graph;
+void te::qt::plugins::fiocruz::FlowGraphImport::setExtendedStatistics(bool extended)
+{
+  m_extendedStatistics = extended;
 }
 
-te::graph::AbstractGraph* te::qt::plugins::fiocruz::FlowGraphImport::buildGraph(bool addStatisticsColumns)
+void te::qt::plugins::fiocruz::FlowGraphImport::setDistanceType(DistanceType type)
 {
-  std::string graphName = "flowGraph";
+  m_distanceType = type;
+}
 
-  // data source information
-  std::map<std::string, std::string> connInfo;
+int te::qt::plugins::fiocruz::FlowGraphImport::readVertices(te::da::DataSet* dataSet, const std::string& idColumn, const std::string& nameColumn,
+                                                             std::vector<VertexRow>& vertices, IdDictionary<int>& vertexRowIdx)
+{
+  ColumnReader id(dataSet, idColumn);
+  ColumnReader name;
 
-  // graph type
-  std::string graphType = te::graph::Globals::sm_factoryGraphTypeBidirectionalGraph;
+  if (!nameColumn.empty())
+    name = ColumnReader(dataSet, nameColumn);
 
-  // graph information
-  std::map<std::string, std::string> graphInfo;
-  graphInfo["GRAPH_DATA_SOURCE_TYPE"] = "MEM";
-  graphInfo["GRAPH_NAME"] = graphName;
-  graphInfo["GRAPH_DESCRIPTION"] = "Generated by Flow Builder.";
+  if (!id.isValid())
+    throw te::common::Exception(TE_TR("Vertex id column not found."));
 
-  te::graph::AbstractGraph* graph = te::graph::AbstractGraphFactory::make(graphType, connInfo, graphInfo);
+  int geomIdx = te::da::GetFirstSpatialPropertyPos(dataSet);
 
-  //create vertex attributes
+  if (geomIdx == -1)
+    throw te::common::Exception(TE_TR("Vertex data set must have a geometry column."));
+
+  int srid = 0;
+  bool hasSRID = false;
+
+  dataSet->moveBeforeFirst();
+
+  while (dataSet->moveNext())
   {
-    te::dt::SimpleProperty* p = new te::dt::StringProperty("name");
-    p->setParent(0);
-    p->setId(0);
-    graph->addVertexProperty(p);
+    if (id.isNull() || dataSet->isNull(geomIdx))
+      continue;
+
+    std::auto_ptr<te::gm::Geometry> geom = dataSet->getGeometry(geomIdx);
+
+    VertexRow row;
+
+    if (!geom.get() || !getCoord(geom.get(), row.m_x, row.m_y))
+      continue;
+
+    if (!hasSRID)
+    {
+      srid = geom->getSRID();
+      hasSRID = true;
+    }
+
+    row.m_id = id.getId();
+    row.m_name = name.isValid() ? name.getString() : "";
+    row.m_graphIdx = -1;
+
+    //the first row of a repeated id is used, the dictionary index is the row position
+    bool added;
+
+    vertexRowIdx.add(row.m_id, added);
+
+    if (added)
+      vertices.push_back(row);
   }
 
+  return srid;
+}
+
+int te::qt::plugins::fiocruz::FlowGraphImport::getVertex(FlowGraph* graph, int id, std::vector<VertexRow>& vertices, const IdDictionary<int>& vertexRowIdx)
+{
+  int rowIdx = vertexRowIdx.getIndex(id);
+
+  if (rowIdx == -1)
+    return -1;
+
+  VertexRow& row = vertices[rowIdx];
+
+  if (row.m_graphIdx == -1)
+    row.m_graphIdx = graph->addVertex(row.m_id, row.m_name, row.m_x, row.m_y);
+
+  return row.m_graphIdx;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraphImport::getCoord(te::gm::Geometry* geom, double& x, double& y)
+{
+  assert(geom);
+
+  return CentroidCache::GetRepresentativePoint(geom, x, y);
+}
+
+std::size_t te::qt::plugins::fiocruz::FlowGraphImport::readBatch(te::da::DataSet* dataSet, int geomidx, std::vector<Row>& batch)
+{
+  if (batch.size() < m_batchSize)
   {
-    te::gm::GeometryProperty* gProp = new te::gm::GeometryProperty("coords");
-    gProp->setId(0);
-    gProp->setGeometryType(te::gm::PointType);
-    graph->addVertexProperty(gProp);
+    Row emptyRow;
+    emptyRow.m_originId = 0;
+    emptyRow.m_destinyId = 0;
+    emptyRow.m_weight = 0.;
+    emptyRow.m_distance = 0.;
+
+    batch.resize(m_batchSize, emptyRow);
   }
 
-  if (addStatisticsColumns)
+  std::size_t nRows = 0;
+
+  while (nRows < m_batchSize && dataSet->moveNext())
   {
-    // Adiciona o campo com o nmero de fluxos de entrada
-    {
-      te::dt::SimpleProperty* p = new te::dt::SimpleProperty("in_flows", te::dt::INT32_TYPE);
-      p->setParent(0);
-      p->setId(0);
-      graph->addVertexProperty(p);
-    }
+    Row& row = batch[nRows];
 
-    // Adiciona o campo com o nmero de fluxos de sada
-    {
-      te::dt::SimpleProperty* p = new te::dt::SimpleProperty("out_flows", te::dt::INT32_TYPE);
-      p->setParent(0);
-      p->setId(0);
-      graph->addVertexProperty(p);
-    }
+    row.m_originId = m_origin.getId();
+    row.m_originName = m_originName.getString();
+    row.m_destinyId = m_destiny.getId();
+    row.m_destinyName = m_destinyName.getString();
+    row.m_weight = m_weight.getDouble();
+    row.m_distance = m_distance.getDouble();
 
-    // Adiciona o campo com o somatrio dos valores dos fluxos de entrada
+    //the geometry encoding depends on the driver, so it is decoded by the data set
+    row.m_geom.reset();
+
+    if (!dataSet->isNull(geomidx))
     {
-      te::dt::SimpleProperty* p = new te::dt::SimpleProperty("sum_in", te::dt::INT32_TYPE);
-      p->setParent(0);
-      p->setId(0);
-      graph->addVertexProperty(p);
+      ++m_geomCount;
+
+      try
+      {
+        row.m_geom.reset(dataSet->getGeometry(geomidx).release());
+      }
+      catch (...)
+      {
+        //invalid geometry, the row is ignored like a row without a line
+      }
+
+      if (!row.m_geom.get())
+        ++m_geomErrorCount;
     }
 
-    // Adiciona o campo com o somatrio dos valores dos fluxos de sada
+    ++nRows;
+  }
+
+  return nRows;
+}
+
+void te::qt::plugins::fiocruz::FlowGraphImport::parseRows(std::vector<Row>& batch, std::size_t begin, std::size_t end, ParsedEdgeBuffer& buffer)
+{
+  for (std::size_t t = begin; t < end; ++t)
+  {
+    Row& row = batch[t];
+
+    if (!row.m_geom.get())
+      continue;
+
+    //get geometry from edge (lineString with 2 coords)
+    te::gm::LineString* line = getLine(row.m_geom.get());
+
+    if (line && line->getNPoints() >= 2)
     {
-      te::dt::SimpleProperty* p = new te::dt::SimpleProperty("sum_out", te::dt::INT32_TYPE);
-      p->setParent(0);
-      p->setId(0);
-      graph->addVertexProperty(p);
+      ParsedEdge edge;
+
+      edge.m_row = t;
+      edge.m_fromId = row.m_originId;
+      edge.m_toId = row.m_destinyId;
+      edge.m_weight = row.m_weight;
+      edge.m_distance = row.m_distance;
+      edge.m_fromX = line->getX(0);
+      edge.m_fromY = line->getY(0);
+      edge.m_toX = line->getX(1);
+      edge.m_toY = line->getY(1);
+      edge.m_srid = line->getSRID();
+
+      buffer.push_back(edge);
     }
-  }
 
-  //create edge attributes
-  {//add from property to graph
-    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("from_id", te::dt::INT32_TYPE);
-    p->setParent(0);
-    p->setId(0);
-    graph->addEdgeProperty(p);
+    row.m_geom.reset();
   }
+}
 
-  {//add from alias property to graph
-    te::dt::SimpleProperty* p = new te::dt::StringProperty("from_name");
-    p->setParent(0);
-    p->setId(0);
-    graph->addEdgeProperty(p);
-  }
+void te::qt::plugins::fiocruz::FlowGraphImport::mergeEdges(FlowGraph* graph, const std::vector<Row>& batch, const ParsedEdgeBuffer& buffer, bool& hasSRID)
+{
+  for (std::size_t t = 0; t < buffer.size(); ++t)
+  {
+    const ParsedEdge& edge = buffer[t];
 
-  {//add to property to graph
-    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("to_id", te::dt::INT32_TYPE);
-    p->setParent(0);
-    p->setId(0);
-    graph->addEdgeProperty(p);
-  }
+    if (!hasSRID)
+    {
+      graph->setSRID(edge.m_srid);
+      hasSRID = true;
+    }
 
-  {//add to alias property to graph
-    te::dt::SimpleProperty* p = new te::dt::StringProperty("to_name");
-    p->setParent(0);
-    p->setId(0);
-    graph->addEdgeProperty(p);
-  }
+    //check if graph has the origin vertex
+    int vFrom = graph->getVertexIndex(edge.m_fromId);
 
-  {//add weight property to graph
-    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("weight", te::dt::INT32_TYPE);
-    p->setParent(0);
-    p->setId(0);
-    graph->addEdgeProperty(p);
-  }
+    if (vFrom == -1)
+      vFrom = graph->addVertex(edge.m_fromId, batch[edge.m_row].m_originName, edge.m_fromX, edge.m_fromY);
 
-  {//add distance property to graph
-    te::dt::SimpleProperty* p = new te::dt::SimpleProperty("distance", te::dt::DOUBLE_TYPE);
-    p->setParent(0);
-    p->setId(0);
-    graph->addEdgeProperty(p);
-  }
+    //check if graph has the destiny vertex
+    int vTo = graph->getVertexIndex(edge.m_toId);
+
+    if (vTo == -1)
+      vTo = graph->addVertex(edge.m_toId, batch[edge.m_row].m_destinyName, edge.m_toX, edge.m_toY);
 
-  return graph;
+    //create edge
+    addFlow(graph, vFrom, vTo, edge.m_weight, edge.m_distance);
+  }
 }
 
-void te::qt::plugins::fiocruz::FlowGraphImport::calculateStatistics(te::graph::AbstractGraph* graph)
+void te::qt::plugins::fiocruz::FlowGraphImport::addFlow(FlowGraph* graph, int vFrom, int vTo, double weight, double distance)
 {
-  //calculate statistics
-  std::auto_ptr<te::graph::MemoryIterator> memIt(new te::graph::MemoryIterator(graph));
+  if (m_appending)
+  {
+    bool added;
 
-  te::graph::Vertex* vertex = memIt->getFirstVertex();
+    int idx = m_pairIndex.add(MakePairKey(vFrom, vTo), added);
 
-  int graphVertexAttrSize = graph->getMetadata()->getVertexPropertySize();
+    if (added)
+      m_pairEdge.push_back(graph->addEdge(vFrom, vTo, weight, distance));
+    else
+      graph->addEdgeWeight(m_pairEdge[idx], weight);
 
-  int weightAttrIdx = getEdgeAttrIdx(graph, "weight");
+    //new vertices are added to the graph before their first flow
+    if (m_changed.size() < graph->getVertexCount())
+      m_changed.resize(graph->getVertexCount(), 0);
 
-  while (vertex)
+    m_changed[vFrom] = 1;
+    m_changed[vTo] = 1;
+  }
+  else if (m_aggregator.get())
+  {
+    m_aggregator->add(vFrom, vTo, weight, distance);
+  }
+  else
   {
-    vertex->setAttributeVecSize(graphVertexAttrSize);
+    graph->addEdge(vFrom, vTo, weight, distance);
+  }
+}
 
-    // Adiciona o campo com o nmero de fluxos de entrada
-    vertex->addAttribute(graphVertexAttrSize - 4, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(vertex->getPredecessors().size()));
+void te::qt::plugins::fiocruz::FlowGraphImport::addAggregatedEdges(FlowGraph* graph)
+{
+  assert(m_aggregator.get());
 
-    // Adiciona o campo com o nmero de fluxos de sada
-    vertex->addAttribute(graphVertexAttrSize - 3, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(vertex->getSuccessors().size()));
+  m_aggregator->finish();
 
-    // Adiciona o campo com o somatrio dos valores dos fluxos de entrada
-    int sumFlowIn = calculateWeightSum(graph, weightAttrIdx, vertex->getPredecessors());
-    vertex->addAttribute(graphVertexAttrSize - 2, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(sumFlowIn));
+  std::vector<int> recordCount;
+
+  AggregatedPair pair;
+
+  while (m_aggregator->next(pair))
+  {
+    //the record count column has 32 bits
+    if (pair.m_count > (boost::uint64_t)std::numeric_limits<int>::max())
+      throw te::common::Exception(TE_TR("Too many flow records with the same origin and destiny."));
 
-    // Adiciona o campo com o somatrio dos valores dos fluxos de sada
-    int sumFlowOut = calculateWeightSum(graph, weightAttrIdx, vertex->getSuccessors());
-    vertex->addAttribute(graphVertexAttrSize - 1, new te::dt::SimpleData<int, te::dt::INT32_TYPE>(sumFlowOut));
+    graph->addEdge(pair.m_from, pair.m_to, pair.m_weight, pair.m_distance / (double)pair.m_count);
 
-    vertex = memIt->getNextVertex();
+    recordCount.push_back((int)pair.m_count);
   }
 
+  //removes the temporary run files
+  m_aggregator.reset();
+
+  graph->initRecordCount();
+  graph->getRecordCount().swap(recordCount);
 }
 
-int te::qt::plugins::fiocruz::FlowGraphImport::calculateWeightSum(te::graph::AbstractGraph* graph, int weighAttrIdx, std::set<int> edges)
+void te::qt::plugins::fiocruz::FlowGraphImport::calculateStatistics(FlowGraph* graph)
 {
-  int count = 0;
+  graph->initStatistics(m_extendedStatistics);
+
+  std::size_t nVertex = graph->getVertexCount();
+  std::size_t nEdge = graph->getEdgeCount();
+
+  const std::vector<int>& from = graph->getEdgeFrom();
+  const std::vector<int>& to = graph->getEdgeTo();
+  const std::vector<double>& weight = graph->getWeight();
+
+  //each thread sweeps a range of edges and accumulates into its own vertex columns
+  std::size_t numThreads = std::min(GetThreadCount(m_numThreads), std::max(nEdge, (std::size_t)1));
 
-  std::set<int>::iterator it = edges.begin();
+  std::vector<StatisticsAccumulator> acc(numThreads);
 
-  for (it = edges.begin(); it != edges.end(); ++it)
+  bool extended = m_extendedStatistics;
+
+  ParallelFor(nEdge, numThreads, [&](std::size_t begin, std::size_t end, std::size_t t)
   {
-    te::graph::Edge* e = graph->getEdge(*it);
+    StatisticsAccumulator& a = acc[t];
+
+    a.m_inFlows.assign(nVertex, 0);
+    a.m_outFlows.assign(nVertex, 0);
+    a.m_sumIn.assign(nVertex, 0.);
+    a.m_sumOut.assign(nVertex, 0.);
 
-    if (e)
+    if (extended)
     {
-      std::string weightStr = e->getAttributes()[weighAttrIdx]->toString();
+      a.m_maxIn.assign(nVertex, -std::numeric_limits<double>::max());
+      a.m_maxOut.assign(nVertex, -std::numeric_limits<double>::max());
+    }
 
-      count += atoi(weightStr.c_str());
+    for (std::size_t e = begin; e < end; ++e)
+    {
+      int vFrom = from[e];
+      int vTo = to[e];
+      double w = weight[e];
+
+      // numero de fluxos e somatorio dos valores dos fluxos de saida
+      ++a.m_outFlows[vFrom];
+      a.m_sumOut[vFrom] += w;
+
+      // numero de fluxos e somatorio dos valores dos fluxos de entrada
+      ++a.m_inFlows[vTo];
+      a.m_sumIn[vTo] += w;
+
+      if (extended)
+      {
+        a.m_maxOut[vFrom] = std::max(a.m_maxOut[vFrom], w);
+        a.m_maxIn[vTo] = std::max(a.m_maxIn[vTo], w);
+      }
     }
-  }
+  });
+
+  //reduce the partial columns, each thread owns a range of vertices
+  std::vector<int>& inFlows = graph->getInFlows();
+  std::vector<int>& outFlows = graph->getOutFlows();
+  std::vector<double>& sumIn = graph->getSumIn();
+  std::vector<double>& sumOut = graph->getSumOut();
+  std::vector<double>& meanIn = graph->getMeanIn();
+  std::vector<double>& meanOut = graph->getMeanOut();
+  std::vector<double>& maxIn = graph->getMaxIn();
+  std::vector<double>& maxOut = graph->getMaxOut();
+
+  ParallelFor(nVertex, m_numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    for (std::size_t v = begin; v < end; ++v)
+    {
+      double vMaxIn = -std::numeric_limits<double>::max();
+      double vMaxOut = -std::numeric_limits<double>::max();
+
+      for (std::size_t t = 0; t < acc.size(); ++t)
+      {
+        const StatisticsAccumulator& a = acc[t];
+
+        inFlows[v] += a.m_inFlows[v];
+        outFlows[v] += a.m_outFlows[v];
+        sumIn[v] += a.m_sumIn[v];
+        sumOut[v] += a.m_sumOut[v];
+
+        if (extended)
+        {
+          vMaxIn = std::max(vMaxIn, a.m_maxIn[v]);
+          vMaxOut = std::max(vMaxOut, a.m_maxOut[v]);
+        }
+      }
 
-  return count;
+      if (extended)
+      {
+        meanIn[v] = inFlows[v] > 0 ? sumIn[v] / inFlows[v] : 0.;
+        meanOut[v] = outFlows[v] > 0 ? sumOut[v] / outFlows[v] : 0.;
+        maxIn[v] = inFlows[v] > 0 ? vMaxIn : 0.;
+        maxOut[v] = outFlows[v] > 0 ? vMaxOut : 0.;
+      }
+    }
+  });
 }
 
-int te::qt::plugins::fiocruz::FlowGraphImport::getEdgeAttrIdx(te::graph::AbstractGraph* graph, std::string attrName)
+void te::qt::plugins::fiocruz::FlowGraphImport::updateStatistics(FlowGraph* graph, const std::vector<int>& vertices)
 {
-  int idx = -1;
-
-  for (int i = 0; i < graph->getEdgePropertySize(); ++i)
+  bool extended = graph->hasExtendedStatistics();
+
+  const std::vector<int>& outOffset = graph->getOutOffsets();
+  const std::vector<int>& outEdges = graph->getOutEdges();
+  const std::vector<int>& inOffset = graph->getInOffsets();
+  const std::vector<int>& inEdges = graph->getInEdges();
+  const std::vector<double>& weight = graph->getWeight();
+
+  std::vector<int>& inFlows = graph->getInFlows();
+  std::vector<int>& outFlows = graph->getOutFlows();
+  std::vector<double>& sumIn = graph->getSumIn();
+  std::vector<double>& sumOut = graph->getSumOut();
+  std::vector<double>& meanIn = graph->getMeanIn();
+  std::vector<double>& meanOut = graph->getMeanOut();
+  std::vector<double>& maxIn = graph->getMaxIn();
+  std::vector<double>& maxOut = graph->getMaxOut();
+
+  for (std::size_t t = 0; t < vertices.size(); ++t)
   {
-    if (graph->getEdgeProperty(i)->getName() == attrName)
+    int v = vertices[t];
+
+    inFlows[v] = inOffset[v + 1] - inOffset[v];
+    outFlows[v] = outOffset[v + 1] - outOffset[v];
+
+    double sum = 0.;
+    double max = 0.;
+
+    for (int i = inOffset[v]; i < inOffset[v + 1]; ++i)
+    {
+      double w = weight[inEdges[i]];
+
+      sum += w;
+      max = (i == inOffset[v] || w > max) ? w : max;
+    }
+
+    sumIn[v] = sum;
+
+    if (extended)
     {
-      idx = i;
-      break;
+      meanIn[v] = inFlows[v] > 0 ? sum / inFlows[v] : 0.;
+      maxIn[v] = max;
     }
-  }
 
-  return idx;
+    sum = 0.;
+    max = 0.;
+
+    for (int i = outOffset[v]; i < outOffset[v + 1]; ++i)
+    {
+      double w = weight[outEdges[i]];
+
+      sum += w;
+      max = (i == outOffset[v] || w > max) ? w : max;
+    }
+
+    sumOut[v] = sum;
+
+    if (extended)
+    {
+      meanOut[v] = outFlows[v] > 0 ? sum / outFlows[v] : 0.;
+      maxOut[v] = max;
+    }
+  }
 }
 
 te::gm::LineString* te::qt::plugins::fiocruz::FlowGraphImport::getLine(te::gm::Geometry* geom)
@@ -345,13 +754,3 @@ te::gm::LineString* te::qt::plugins::fiocruz::FlowGraphImport::getLine(te::gm::G
 
   return line;
 }
-
-int  te::qt::plugins::fiocruz::FlowGraphImport::getEdgeId()
-{
-  int id = m_edgeId;
-
-  m_edgeId++;
-
-  return id;
-}
-
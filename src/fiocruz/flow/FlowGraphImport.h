@@ -29,13 +29,21 @@ TerraLib Team at <terralib-team@terralib.org>.
 // TerraLib
 #include <terralib/dataaccess/datasource/DataSource.h>
 #include <terralib/geometry/LineString.h>
-#include <terralib/graph/core/AbstractGraph.h>
-#include <terralib/memory/DataSet.h>
 
+#include "../ColumnReader.h"
 #include "../Config.h"
+#include "core/DistanceKernel.h"
+#include "core/FlowGraph.h"
+#include "core/FlowPairAggregator.h"
+#include "core/IdDictionary.h"
 
 // STL
 #include <memory>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/shared_ptr.hpp>
 
 namespace te
 {
@@ -61,31 +69,229 @@ namespace te
 
           public:
 
-            te::graph::AbstractGraph* importGraph(std::auto_ptr<te::da::DataSet> dataSet, int geomidx, bool addStatisticsColumns);
+            /*!
+            \brief Function used to build a flow graph from a flow data set.
+
+            \param dataSet                Data set with the flow columns (from_id, from_name, to_id, to_name, weight, distance), the numeric columns are read with their native type
+            \param geomidx                Index of the line geometry column
+            \param addStatisticsColumns   Flag used to calculate the vertex statistics columns
+
+            \return A new flow graph, the caller takes the ownership.
+            */
+            FlowGraph* importGraph(std::auto_ptr<te::da::DataSet> dataSet, int geomidx, bool addStatisticsColumns);
+
+            /*!
+            \brief Function used to build a flow graph from a tabular flow data set and a vertex data set.
+
+            The flow rows do not need a geometry, the vertex coordinates are read once per
+            vertex from the vertex data set (point or polygon centroid). Flow rows that
+            reference an id missing in the vertex data set are ignored. Without a distance
+            column, the edge distances are calculated from the vertex coordinates (see setDistanceType).
+
+            \param flowDataSet            Data set with the flow columns (from_id, to_id, weight and, optionally, distance)
+            \param vertexDataSet          Data set with one row per vertex and a geometry column
+            \param vertexIdColumn         Name of the vertex id column, it must match the from_id / to_id values
+            \param vertexNameColumn       Name of the vertex name column, it may be empty
+            \param addStatisticsColumns   Flag used to calculate the vertex statistics columns
+
+            \return A new flow graph, the caller takes the ownership.
+            */
+            FlowGraph* importGraph(std::auto_ptr<te::da::DataSet> flowDataSet, std::auto_ptr<te::da::DataSet> vertexDataSet,
+                                   const std::string& vertexIdColumn, const std::string& vertexNameColumn, bool addStatisticsColumns);
+
+            /*!
+            \brief Function used to merge a delta flow data set (e.g. a new month of records) into an existing flow graph.
+
+            A row whose (from_id, to_id) pair already exists in the graph adds its weight
+            (and one record, if the graph has the record count column) to that edge, the
+            other rows create new edges and, if needed, new vertices. The graph is rebuilt
+            and, if it has statistics, they are recalculated only for the changed vertices.
+            The calculated columns of the new vertices and edges get their initial values,
+            use FlowDominance::update and CalculateMainFlow::update to refresh them.
+
+            A graph loaded from a snapshot can be used, save it again to keep the merged data.
+
+            \param graph     The graph to be changed
+            \param dataSet   Data set with the same columns used by importGraph
+            \param geomidx   Index of the line geometry column
+
+            \return The dense indexes of the vertices with new or changed edges, in increasing order.
+            */
+            std::vector<int> appendGraph(FlowGraph* graph, std::auto_ptr<te::da::DataSet> dataSet, int geomidx);
+
+            /*!
+            \brief Defines the number of threads used to parse the flow rows.
+
+            \param numThreads   Number of worker threads, 1 reads and parses in the calling thread (default) and 0 uses one thread per core
+            */
+            void setNumberOfThreads(std::size_t numThreads);
+
+            /*! \brief Defines the number of rows read from the data set before they are handed to the workers. */
+            void setBatchSize(std::size_t batchSize);
+
+            /*!
+            \brief Defines if the flow rows with the same origin and destiny are merged in a single edge.
+
+            Use it when the input has one row per individual record instead of aggregated
+            flows. The merged edge has the summed weight, the mean distance and the number
+            of records (record count column). If the number of distinct pairs exceeds
+            maxPairs, the pairs are spilled to sorted temporary files and merged at the end.
+
+            \param aggregate   Flag used to merge the duplicated pairs (default false)
+            \param maxPairs    Maximum number of distinct pairs kept in memory
+            */
+            void setAggregatePairs(bool aggregate, std::size_t maxPairs = 4194304);
+
+            /*! \brief Defines if the mean and max flow values of each vertex are added to the statistics columns (default false). */
+            void setExtendedStatistics(bool extended);
+
+            /*!
+            \brief Defines the metric used to fill the edge distances when the flow data set has no distance column.
+
+            \param type   Distance metric (default DISTANCE_PLANAR), the geodesic types expect lat/long vertices and give meters
+            */
+            void setDistanceType(DistanceType type);
 
           protected:
 
-            te::graph::AbstractGraph* buildGraph(bool addStatisticsColumns);
+            /*!
+            \struct Row
+
+            \brief Raw values of one flow row as read from the data set.
+            */
+            struct Row
+            {
+              int m_originId;
+              std::string m_originName;
+              int m_destinyId;
+              std::string m_destinyName;
+              double m_weight;
+              double m_distance;
+              boost::shared_ptr<te::gm::Geometry> m_geom;   //!< Line geometry decoded by the data set, it is validated by the workers
+            };
+
+            /*!
+            \struct ParsedEdge
 
-            void calculateStatistics(te::graph::AbstractGraph* graph);
+            \brief Validated edge produced by a worker from a raw row.
+            */
+            struct ParsedEdge
+            {
+              std::size_t m_row;          //!< Row position inside the batch (used to get the names)
+              int m_fromId;
+              int m_toId;
+              double m_weight;
+              double m_distance;
+              double m_fromX;
+              double m_fromY;
+              double m_toX;
+              double m_toY;
+              int m_srid;
+            };
 
-            int calculateWeightSum(te::graph::AbstractGraph* graph, int weighAttrIdx, std::set<int> edges);
+            typedef std::vector<ParsedEdge> ParsedEdgeBuffer;
 
-            int getEdgeAttrIdx(te::graph::AbstractGraph* graph, std::string attrName);
+            /*!
+            \struct VertexRow
 
-            te::gm::LineString* getLine(te::gm::Geometry* geom);
+            \brief Vertex read from a vertex data set, it is added to the graph only if it is used by a flow.
+            */
+            struct VertexRow
+            {
+              int m_id;
+              std::string m_name;
+              double m_x;
+              double m_y;
+              int m_graphIdx;             //!< Dense index inside the graph or -1 if not added yet
+            };
+
+            /*! \brief Reads all rows of a vertex data set, returns the SRID of the vertex geometries. */
+            int readVertices(te::da::DataSet* dataSet, const std::string& idColumn, const std::string& nameColumn,
+                             std::vector<VertexRow>& vertices, IdDictionary<int>& vertexRowIdx);
+
+            /*! \brief Gets the graph index of a vertex from the vertex table, the vertex is added on first use. Returns -1 if the id is unknown. */
+            int getVertex(FlowGraph* graph, int id, std::vector<VertexRow>& vertices, const IdDictionary<int>& vertexRowIdx);
+
+            /*! \brief Gets the representative coordinate of a vertex geometry (see CentroidCache::GetRepresentativePoint). */
+            bool getCoord(te::gm::Geometry* geom, double& x, double& y);
+
+            /*! \brief Reads all rows of a flow data set with line geometries and adds them to the graph. */
+            void readFlows(FlowGraph* graph, te::da::DataSet* dataSet, int geomidx, bool& hasSRID);
+
+            /*!
+            \brief Reads up to m_batchSize rows from the data set, returns the number of rows read.
+
+            The geometries are decoded by the data set driver, the rows whose geometry
+            could not be decoded are counted in m_geomErrorCount.
+            */
+            std::size_t readBatch(te::da::DataSet* dataSet, int geomidx, std::vector<Row>& batch);
 
             /*!
-            \brief Function used to generated the edge id
+            \brief Parses the rows [begin, end) of a batch into a edge buffer, it may run in a worker thread.
+
+            The line of each row is validated here, rows without a line with two points are
+            ignored. No exception leaves this function.
+            */
+            void parseRows(std::vector<Row>& batch, std::size_t begin, std::size_t end, ParsedEdgeBuffer& buffer);
+
+            /*! \brief Adds the parsed edges to the graph, in row order. */
+            void mergeEdges(FlowGraph* graph, const std::vector<Row>& batch, const ParsedEdgeBuffer& buffer, bool& hasSRID);
 
-            \return Integer value as ID
+            /*! \brief Adds a flow to the graph, to the edge of its pair when appending or to the pair aggregator if the aggregation is enabled. */
+            void addFlow(FlowGraph* graph, int vFrom, int vTo, double weight, double distance);
 
+            /*! \brief Creates one edge for each aggregated pair and fills the record count column. */
+            void addAggregatedEdges(FlowGraph* graph);
+
+            /*!
+            \struct StatisticsAccumulator
+
+            \brief Partial vertex statistics of the edges swept by one thread.
             */
-            int getEdgeId();
+            struct StatisticsAccumulator
+            {
+              std::vector<int> m_inFlows;
+              std::vector<int> m_outFlows;
+              std::vector<double> m_sumIn;
+              std::vector<double> m_sumOut;
+              std::vector<double> m_maxIn;
+              std::vector<double> m_maxOut;
+            };
+
+            /*! \brief Calculates the vertex statistics in one parallel sweep over the edge columns. */
+            void calculateStatistics(FlowGraph* graph);
+
+            /*! \brief Recalculates the statistics of the given vertices from their adjacency. */
+            void updateStatistics(FlowGraph* graph, const std::vector<int>& vertices);
+
+            te::gm::LineString* getLine(te::gm::Geometry* geom);
 
           protected:
 
-            int m_edgeId;  //!< Attribute used as a index counter for edge objects
+            std::size_t m_numThreads;   //!< Number of threads used to parse the rows
+            std::size_t m_batchSize;    //!< Number of rows per batch
+
+            bool m_aggregatePairs;      //!< Merge the rows with the same origin and destiny
+            std::size_t m_maxPairs;     //!< Maximum number of distinct pairs kept in memory while aggregating
+            bool m_extendedStatistics;  //!< Add the mean and max columns to the statistics
+            DistanceType m_distanceType;  //!< Metric of the calculated distances
+
+            std::auto_ptr<FlowPairAggregator> m_aggregator;   //!< Pair aggregator of the current import
+
+            bool m_appending;                         //!< The flows are being merged into an existing graph
+            IdDictionary<boost::int64_t> m_pairIndex; //!< Origin / destiny pair to position in m_pairEdge while appending
+            std::vector<int> m_pairEdge;              //!< Edge of each pair while appending
+            std::vector<unsigned char> m_changed;     //!< Flag of the vertices with new or changed edges while appending
+
+            std::size_t m_geomCount;        //!< Rows with a not null geometry read by readFlows
+            std::size_t m_geomErrorCount;   //!< Rows whose geometry could not be decoded by the data set
+
+            ColumnReader m_origin;          //!< Reader of the from_id column
+            ColumnReader m_originName;      //!< Reader of the from_name column
+            ColumnReader m_destiny;         //!< Reader of the to_id column
+            ColumnReader m_destinyName;     //!< Reader of the to_name column
+            ColumnReader m_weight;          //!< Reader of the weight column
+            ColumnReader m_distance;        //!< Reader of the distance column
 
         };
       }   // end namespace fiocruz
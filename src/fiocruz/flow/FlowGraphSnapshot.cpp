@@ -0,0 +1,540 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/FlowGraphSnapshot.cpp
+
+\brief This file defines the Flow Graph Snapshot class
+*/
+
+#include "FlowGraphSnapshot.h"
+
+// TerraLib
+#include <terralib/common/Exception.h>
+#include <terralib/common/Translator.h>
+
+// STL
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+
+// Boost
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace
+{
+  const char SNAPSHOT_MAGIC[8] = { 'F', 'L', 'O', 'W', 'S', 'N', 'A', 'P' };
+
+  const char HIERARCHY_MAGIC[8] = { 'F', 'L', 'O', 'W', 'H', 'I', 'E', 'R' };
+
+  const boost::uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+  boost::uint64_t Align(boost::uint64_t value)
+  {
+    return (value + 7) & ~(boost::uint64_t)7;
+  }
+
+  template<class T> void WriteColumn(std::ofstream& out, const std::vector<T>& column)
+  {
+    if (!column.empty())
+      out.write(reinterpret_cast<const char*>(&column[0]), column.size() * sizeof(T));
+
+    //pad to the next section
+    static const char zeros[8] = { 0 };
+
+    std::size_t size = column.size() * sizeof(T);
+
+    out.write(zeros, Align(size) - size);
+  }
+
+  /*! \brief Returns true if every value of an index column is in [0, count). */
+  bool CheckIndexes(const std::vector<int>& column, std::size_t count)
+  {
+    for (std::size_t i = 0; i < column.size(); ++i)
+    {
+      if (column[i] < 0 || (std::size_t)column[i] >= count)
+        return false;
+    }
+
+    return true;
+  }
+
+  /*!
+    \brief Returns true if a CSR adjacency is consistent: the offsets start at 0, never decrease
+    and end at the edge count, and each listed edge has the vertex as its endpoint.
+  */
+  bool CheckAdjacency(const std::vector<int>& offset, const std::vector<int>& edges, const std::vector<int>& endpoint)
+  {
+    if (offset.empty() || offset[0] != 0 || (std::size_t)offset.back() != edges.size())
+      return false;
+
+    for (std::size_t v = 0; v + 1 < offset.size(); ++v)
+    {
+      if (offset[v] > offset[v + 1])
+        return false;
+    }
+
+    if (!CheckIndexes(edges, endpoint.size()))
+      return false;
+
+    for (std::size_t v = 0; v + 1 < offset.size(); ++v)
+    {
+      for (int t = offset[v]; t < offset[v + 1]; ++t)
+      {
+        if ((std::size_t)endpoint[edges[t]] != v)
+          return false;
+      }
+    }
+
+    return true;
+  }
+}
+
+te::qt::plugins::fiocruz::FlowGraphSnapshot::FlowGraphSnapshot()
+{
+
+}
+
+te::qt::plugins::fiocruz::FlowGraphSnapshot::~FlowGraphSnapshot()
+{
+
+}
+
+void te::qt::plugins::fiocruz::FlowGraphSnapshot::save(FlowGraph* graph, const std::string& fileName)
+{
+  assert(graph);
+
+  if (!graph->isBuilt())
+    graph->build();
+
+  std::size_t nVertex = graph->getVertexCount();
+  std::size_t nEdge = graph->getEdgeCount();
+
+  //the name pool is written as is, the vertices keep their name handles
+  const StringPool& namePool = *graph->m_namePool;
+  const std::vector<boost::uint32_t>& vertexName = graph->m_vertexName;
+  std::vector<boost::uint32_t> nameOffset(1, 0);
+  std::vector<char> nameChars;
+
+  for (std::size_t i = 0; i < namePool.size(); ++i)
+  {
+    const std::string& name = namePool.get((boost::uint32_t)i);
+
+    nameChars.insert(nameChars.end(), name.begin(), name.end());
+    nameOffset.push_back((boost::uint32_t)nameChars.size());
+  }
+
+  bool hasStatistics = graph->hasStatistics();
+  bool hasExtendedStatistics = graph->hasExtendedStatistics();
+  bool hasRecordCount = graph->hasRecordCount();
+
+  //fill header
+  Header header;
+  memset(&header, 0, sizeof(Header));
+  memcpy(header.m_magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+
+  header.m_version = FIOCRUZ_FLOWGRAPH_SNAPSHOT_VERSION;
+  header.m_byteOrder = SNAPSHOT_BYTE_ORDER;
+  header.m_vertexCount = nVertex;
+  header.m_edgeCount = nEdge;
+  header.m_nameCount = namePool.size();
+  header.m_srid = graph->getSRID();
+  header.m_hasStatistics = hasStatistics ? 1 : 0;
+  header.m_hasRecordCount = hasRecordCount ? 1 : 0;
+  header.m_hasExtendedStatistics = hasExtendedStatistics ? 1 : 0;
+
+  boost::uint64_t offset = Align(sizeof(Header));
+
+  setSection(header, SECTION_VERTEX_ID, nVertex * sizeof(int), offset);
+  setSection(header, SECTION_VERTEX_X, nVertex * sizeof(double), offset);
+  setSection(header, SECTION_VERTEX_Y, nVertex * sizeof(double), offset);
+  setSection(header, SECTION_VERTEX_NAME, nVertex * sizeof(boost::uint32_t), offset);
+  setSection(header, SECTION_NAME_OFFSET, nameOffset.size() * sizeof(boost::uint32_t), offset);
+  setSection(header, SECTION_NAME_CHARS, nameChars.size(), offset);
+  setSection(header, SECTION_EDGE_FROM, nEdge * sizeof(int), offset);
+  setSection(header, SECTION_EDGE_TO, nEdge * sizeof(int), offset);
+  setSection(header, SECTION_EDGE_WEIGHT, nEdge * sizeof(double), offset);
+  setSection(header, SECTION_EDGE_DISTANCE, nEdge * sizeof(double), offset);
+  setSection(header, SECTION_OUT_OFFSET, (nVertex + 1) * sizeof(int), offset);
+  setSection(header, SECTION_OUT_EDGE, nEdge * sizeof(int), offset);
+  setSection(header, SECTION_IN_OFFSET, (nVertex + 1) * sizeof(int), offset);
+  setSection(header, SECTION_IN_EDGE, nEdge * sizeof(int), offset);
+  setSection(header, SECTION_IN_FLOWS, hasStatistics ? nVertex * sizeof(int) : 0, offset);
+  setSection(header, SECTION_OUT_FLOWS, hasStatistics ? nVertex * sizeof(int) : 0, offset);
+  setSection(header, SECTION_SUM_IN, hasStatistics ? nVertex * sizeof(double) : 0, offset);
+  setSection(header, SECTION_SUM_OUT, hasStatistics ? nVertex * sizeof(double) : 0, offset);
+  setSection(header, SECTION_RECORD_COUNT, hasRecordCount ? nEdge * sizeof(int) : 0, offset);
+  setSection(header, SECTION_MEAN_IN, hasExtendedStatistics ? nVertex * sizeof(double) : 0, offset);
+  setSection(header, SECTION_MEAN_OUT, hasExtendedStatistics ? nVertex * sizeof(double) : 0, offset);
+  setSection(header, SECTION_MAX_IN, hasExtendedStatistics ? nVertex * sizeof(double) : 0, offset);
+  setSection(header, SECTION_MAX_OUT, hasExtendedStatistics ? nVertex * sizeof(double) : 0, offset);
+
+  //write file, the column order must follow the section order
+  std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open())
+    throw te::common::Exception(TE_TR("Could not create the flow graph snapshot file."));
+
+  std::vector<char> headerBytes(Align(sizeof(Header)), 0);
+  memcpy(&headerBytes[0], &header, sizeof(Header));
+  WriteColumn(out, headerBytes);
+
+  WriteColumn(out, graph->m_vertexId);
+  WriteColumn(out, graph->m_vertexX);
+  WriteColumn(out, graph->m_vertexY);
+  WriteColumn(out, vertexName);
+  WriteColumn(out, nameOffset);
+  WriteColumn(out, nameChars);
+  WriteColumn(out, graph->m_edgeFrom);
+  WriteColumn(out, graph->m_edgeTo);
+  WriteColumn(out, graph->m_weight);
+  WriteColumn(out, graph->m_distance);
+  WriteColumn(out, graph->m_outOffset);
+  WriteColumn(out, graph->m_outEdge);
+  WriteColumn(out, graph->m_inOffset);
+  WriteColumn(out, graph->m_inEdge);
+
+  if (hasStatistics)
+  {
+    WriteColumn(out, graph->m_inFlows);
+    WriteColumn(out, graph->m_outFlows);
+    WriteColumn(out, graph->m_sumIn);
+    WriteColumn(out, graph->m_sumOut);
+  }
+
+  if (hasRecordCount)
+    WriteColumn(out, graph->m_recordCount);
+
+  if (hasExtendedStatistics)
+  {
+    WriteColumn(out, graph->m_meanIn);
+    WriteColumn(out, graph->m_meanOut);
+    WriteColumn(out, graph->m_maxIn);
+    WriteColumn(out, graph->m_maxOut);
+  }
+
+  out.close();
+
+  if (out.fail())
+    throw te::common::Exception(TE_TR("Error writing the flow graph snapshot file."));
+}
+
+te::qt::plugins::fiocruz::FlowGraph* te::qt::plugins::fiocruz::FlowGraphSnapshot::load(const std::string& fileName)
+{
+  std::auto_ptr<te::qt::plugins::fiocruz::FlowGraph> graph;
+
+  try
+  {
+    boost::interprocess::file_mapping file(fileName.c_str(), boost::interprocess::read_only);
+
+    boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+
+    const char* base = static_cast<const char*>(region.get_address());
+
+    boost::uint64_t fileSize = region.get_size();
+
+    //check header
+    if (fileSize < sizeof(Header))
+      throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+
+    Header header;
+    memcpy(&header, base, sizeof(Header));
+
+    if (memcmp(header.m_magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+      throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+
+    if (header.m_byteOrder != SNAPSHOT_BYTE_ORDER)
+      throw te::common::Exception(TE_TR("Flow graph snapshot was written with a different byte order."));
+
+    if (header.m_version != FIOCRUZ_FLOWGRAPH_SNAPSHOT_VERSION)
+      throw te::common::Exception(TE_TR("Unsupported flow graph snapshot version."));
+
+    std::size_t nVertex = (std::size_t)header.m_vertexCount;
+    std::size_t nEdge = (std::size_t)header.m_edgeCount;
+    std::size_t nNames = (std::size_t)header.m_nameCount;
+
+    //each vertex, edge and name uses some bytes of the file, so larger counts are corrupt
+    if (header.m_vertexCount > fileSize || header.m_edgeCount > fileSize || header.m_nameCount > fileSize)
+      throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+
+    graph.reset(new te::qt::plugins::fiocruz::FlowGraph());
+
+    graph->setSRID(header.m_srid);
+
+    //vertex columns
+    copySection(header, SECTION_VERTEX_ID, base, fileSize, nVertex, graph->m_vertexId);
+    copySection(header, SECTION_VERTEX_X, base, fileSize, nVertex, graph->m_vertexX);
+    copySection(header, SECTION_VERTEX_Y, base, fileSize, nVertex, graph->m_vertexY);
+
+    //names
+    std::vector<boost::uint32_t> nameOffset;
+    copySection(header, SECTION_NAME_OFFSET, base, fileSize, nNames + 1, nameOffset);
+
+    //the offsets must not decrease, so every name is inside the chars section
+    for (std::size_t i = 0; i < nNames; ++i)
+    {
+      if (nameOffset[i] > nameOffset[i + 1])
+        throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+    }
+
+    const char* nameChars = getSection(header, SECTION_NAME_CHARS, base, fileSize, nameOffset[nNames]);
+
+    graph->m_namePool->reserve(nNames);
+
+    for (std::size_t i = 0; i < nNames; ++i)
+    {
+      std::string name(nameChars + nameOffset[i], nameChars + nameOffset[i + 1]);
+
+      if (graph->m_namePool->add(name) != i)
+        throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+    }
+
+    copySection(header, SECTION_VERTEX_NAME, base, fileSize, nVertex, graph->m_vertexName);
+
+    for (std::size_t v = 0; v < nVertex; ++v)
+    {
+      if (graph->m_vertexName[v] >= nNames)
+        throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+    }
+
+    //edge columns
+    copySection(header, SECTION_EDGE_FROM, base, fileSize, nEdge, graph->m_edgeFrom);
+    copySection(header, SECTION_EDGE_TO, base, fileSize, nEdge, graph->m_edgeTo);
+    copySection(header, SECTION_EDGE_WEIGHT, base, fileSize, nEdge, graph->m_weight);
+    copySection(header, SECTION_EDGE_DISTANCE, base, fileSize, nEdge, graph->m_distance);
+
+    //adjacency
+    copySection(header, SECTION_OUT_OFFSET, base, fileSize, nVertex + 1, graph->m_outOffset);
+    copySection(header, SECTION_OUT_EDGE, base, fileSize, nEdge, graph->m_outEdge);
+    copySection(header, SECTION_IN_OFFSET, base, fileSize, nVertex + 1, graph->m_inOffset);
+    copySection(header, SECTION_IN_EDGE, base, fileSize, nEdge, graph->m_inEdge);
+
+    //the algorithms index the columns without checks, a corrupt file must not reach them
+    if (nEdge > (std::size_t)std::numeric_limits<int>::max() ||
+        !CheckIndexes(graph->m_edgeFrom, nVertex) || !CheckIndexes(graph->m_edgeTo, nVertex) ||
+        !CheckAdjacency(graph->m_outOffset, graph->m_outEdge, graph->m_edgeFrom) ||
+        !CheckAdjacency(graph->m_inOffset, graph->m_inEdge, graph->m_edgeTo))
+      throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+
+    //statistics
+    if (header.m_hasStatistics)
+    {
+      copySection(header, SECTION_IN_FLOWS, base, fileSize, nVertex, graph->m_inFlows);
+      copySection(header, SECTION_OUT_FLOWS, base, fileSize, nVertex, graph->m_outFlows);
+      copySection(header, SECTION_SUM_IN, base, fileSize, nVertex, graph->m_sumIn);
+      copySection(header, SECTION_SUM_OUT, base, fileSize, nVertex, graph->m_sumOut);
+
+      graph->m_hasStatistics = true;
+    }
+
+    if (header.m_hasRecordCount)
+    {
+      copySection(header, SECTION_RECORD_COUNT, base, fileSize, nEdge, graph->m_recordCount);
+
+      graph->m_hasRecordCount = true;
+    }
+
+    if (header.m_hasStatistics && header.m_hasExtendedStatistics)
+    {
+      copySection(header, SECTION_MEAN_IN, base, fileSize, nVertex, graph->m_meanIn);
+      copySection(header, SECTION_MEAN_OUT, base, fileSize, nVertex, graph->m_meanOut);
+      copySection(header, SECTION_MAX_IN, base, fileSize, nVertex, graph->m_maxIn);
+      copySection(header, SECTION_MAX_OUT, base, fileSize, nVertex, graph->m_maxOut);
+
+      graph->m_hasExtendedStatistics = true;
+    }
+  }
+  catch (boost::interprocess::interprocess_exception&)
+  {
+    throw te::common::Exception(TE_TR("Could not open the flow graph snapshot file."));
+  }
+
+  //the external id index is not stored
+  graph->m_vertexIndex.reserve(graph->m_vertexId.size());
+
+  for (std::size_t v = 0; v < graph->m_vertexId.size(); ++v)
+  {
+    if (graph->m_vertexIndex.add(graph->m_vertexId[v]) != (int)v)
+      throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+  }
+
+  graph->m_built = true;
+
+  return graph.release();
+}
+
+void te::qt::plugins::fiocruz::FlowGraphSnapshot::saveHierarchy(const FlowHierarchy& hierarchy, const std::string& fileName)
+{
+  std::size_t nVertex = hierarchy.getVertexCount();
+  std::size_t nRoots = hierarchy.m_roots.size();
+
+  //fill header
+  HierarchyHeader header;
+  memset(&header, 0, sizeof(HierarchyHeader));
+  memcpy(header.m_magic, HIERARCHY_MAGIC, sizeof(HIERARCHY_MAGIC));
+
+  header.m_version = FIOCRUZ_FLOWHIERARCHY_SNAPSHOT_VERSION;
+  header.m_byteOrder = SNAPSHOT_BYTE_ORDER;
+  header.m_vertexCount = nVertex;
+  header.m_rootCount = nRoots;
+
+  boost::uint64_t offset = Align(sizeof(HierarchyHeader));
+
+  setSection(header, HIERARCHY_SECTION_PARENT, nVertex * sizeof(int), offset);
+  setSection(header, HIERARCHY_SECTION_ROOT, nVertex * sizeof(int), offset);
+  setSection(header, HIERARCHY_SECTION_DEPTH, nVertex * sizeof(int), offset);
+  setSection(header, HIERARCHY_SECTION_ROOTS, nRoots * sizeof(int), offset);
+  setSection(header, HIERARCHY_SECTION_PREORDER, nVertex * sizeof(int), offset);
+  setSection(header, HIERARCHY_SECTION_ENTER, nVertex * sizeof(int), offset);
+  setSection(header, HIERARCHY_SECTION_EXIT, nVertex * sizeof(int), offset);
+
+  //write file, the column order must follow the section order
+  std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open())
+    throw te::common::Exception(TE_TR("Could not create the flow hierarchy file."));
+
+  std::vector<char> headerBytes(Align(sizeof(HierarchyHeader)), 0);
+  memcpy(&headerBytes[0], &header, sizeof(HierarchyHeader));
+  WriteColumn(out, headerBytes);
+
+  WriteColumn(out, hierarchy.m_parent);
+  WriteColumn(out, hierarchy.m_root);
+  WriteColumn(out, hierarchy.m_depth);
+  WriteColumn(out, hierarchy.m_roots);
+  WriteColumn(out, hierarchy.m_preorder);
+  WriteColumn(out, hierarchy.m_enter);
+  WriteColumn(out, hierarchy.m_exit);
+
+  out.close();
+
+  if (out.fail())
+    throw te::common::Exception(TE_TR("Error writing the flow hierarchy file."));
+}
+
+te::qt::plugins::fiocruz::FlowHierarchy* te::qt::plugins::fiocruz::FlowGraphSnapshot::loadHierarchy(const std::string& fileName)
+{
+  std::auto_ptr<te::qt::plugins::fiocruz::FlowHierarchy> hierarchy(new te::qt::plugins::fiocruz::FlowHierarchy());
+
+  try
+  {
+    boost::interprocess::file_mapping file(fileName.c_str(), boost::interprocess::read_only);
+
+    boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+
+    const char* base = static_cast<const char*>(region.get_address());
+
+    boost::uint64_t fileSize = region.get_size();
+
+    //check header
+    if (fileSize < sizeof(HierarchyHeader))
+      throw te::common::Exception(TE_TR("Invalid flow hierarchy file."));
+
+    HierarchyHeader header;
+    memcpy(&header, base, sizeof(HierarchyHeader));
+
+    if (memcmp(header.m_magic, HIERARCHY_MAGIC, sizeof(HIERARCHY_MAGIC)) != 0)
+      throw te::common::Exception(TE_TR("Invalid flow hierarchy file."));
+
+    if (header.m_byteOrder != SNAPSHOT_BYTE_ORDER)
+      throw te::common::Exception(TE_TR("Flow hierarchy file was written with a different byte order."));
+
+    if (header.m_version != FIOCRUZ_FLOWHIERARCHY_SNAPSHOT_VERSION)
+      throw te::common::Exception(TE_TR("Unsupported flow hierarchy file version."));
+
+    std::size_t nVertex = (std::size_t)header.m_vertexCount;
+    std::size_t nRoots = (std::size_t)header.m_rootCount;
+
+    copySection(header, HIERARCHY_SECTION_PARENT, base, fileSize, nVertex, hierarchy->m_parent);
+    copySection(header, HIERARCHY_SECTION_ROOT, base, fileSize, nVertex, hierarchy->m_root);
+    copySection(header, HIERARCHY_SECTION_DEPTH, base, fileSize, nVertex, hierarchy->m_depth);
+    copySection(header, HIERARCHY_SECTION_ROOTS, base, fileSize, nRoots, hierarchy->m_roots);
+    copySection(header, HIERARCHY_SECTION_PREORDER, base, fileSize, nVertex, hierarchy->m_preorder);
+    copySection(header, HIERARCHY_SECTION_ENTER, base, fileSize, nVertex, hierarchy->m_enter);
+    copySection(header, HIERARCHY_SECTION_EXIT, base, fileSize, nVertex, hierarchy->m_exit);
+  }
+  catch (boost::interprocess::interprocess_exception&)
+  {
+    throw te::common::Exception(TE_TR("Could not open the flow hierarchy file."));
+  }
+
+  //the queries index the columns with these values
+  int n = (int)hierarchy->m_parent.size();
+
+  for (int v = 0; v < n; ++v)
+  {
+    int enter = hierarchy->m_enter[v];
+
+    if (hierarchy->m_parent[v] < -1 || hierarchy->m_parent[v] >= n ||
+        hierarchy->m_root[v] < 0 || hierarchy->m_root[v] >= n ||
+        hierarchy->m_preorder[v] < 0 || hierarchy->m_preorder[v] >= n ||
+        enter < 0 || enter >= n || hierarchy->m_exit[v] <= enter || hierarchy->m_exit[v] > n ||
+        hierarchy->m_preorder[enter] != v || hierarchy->m_depth[v] < 0 || hierarchy->m_depth[v] >= n)
+      throw te::common::Exception(TE_TR("Invalid flow hierarchy file."));
+  }
+
+  //the columns must describe the same forest: a vertex is one level below its parent, in
+  //the same tree and inside the parent preorder interval. The depth check also rules out
+  //parent cycles, the path to the root would loop forever.
+  int nTop = 0;
+
+  for (int v = 0; v < n; ++v)
+  {
+    int parent = hierarchy->m_parent[v];
+
+    if (parent == -1)
+    {
+      ++nTop;
+
+      if (hierarchy->m_depth[v] != 0 || hierarchy->m_root[v] != v)
+        throw te::common::Exception(TE_TR("Invalid flow hierarchy file."));
+
+      continue;
+    }
+
+    if (hierarchy->m_depth[v] != hierarchy->m_depth[parent] + 1 ||
+        hierarchy->m_root[v] != hierarchy->m_root[parent] ||
+        hierarchy->m_enter[v] <= hierarchy->m_enter[parent] || hierarchy->m_exit[v] > hierarchy->m_exit[parent])
+      throw te::common::Exception(TE_TR("Invalid flow hierarchy file."));
+  }
+
+  //the top poles are the vertices without parent, in vertex order
+  if ((int)hierarchy->m_roots.size() != nTop)
+    throw te::common::Exception(TE_TR("Invalid flow hierarchy file."));
+
+  for (std::size_t r = 0; r < hierarchy->m_roots.size(); ++r)
+  {
+    int root = hierarchy->m_roots[r];
+
+    if (root < 0 || root >= n || hierarchy->m_parent[root] != -1 || (r > 0 && root <= hierarchy->m_roots[r - 1]))
+      throw te::common::Exception(TE_TR("Invalid flow hierarchy file."));
+  }
+
+  hierarchy->buildSparseTable();
+
+  return hierarchy.release();
+}
+
+void te::qt::plugins::fiocruz::FlowGraphSnapshot::throwInvalidFile()
+{
+  throw te::common::Exception(TE_TR("Invalid flow graph snapshot file."));
+}
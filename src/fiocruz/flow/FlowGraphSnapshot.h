@@ -0,0 +1,264 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/FlowGraphSnapshot.h
+
+\brief This file defines the Flow Graph Snapshot class
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHSNAPSHOT_H
+#define __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHSNAPSHOT_H
+
+#include "../Config.h"
+#include "core/FlowGraph.h"
+#include "core/FlowHierarchy.h"
+
+// STL
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/cstdint.hpp>
+
+/*!
+\def FIOCRUZ_FLOWGRAPH_SNAPSHOT_VERSION
+
+\brief Version of the flow graph snapshot file format, files with other versions are rejected.
+*/
+#define FIOCRUZ_FLOWGRAPH_SNAPSHOT_VERSION 3
+
+/*!
+\def FIOCRUZ_FLOWHIERARCHY_SNAPSHOT_VERSION
+
+\brief Version of the flow hierarchy file format, files with other versions are rejected.
+*/
+#define FIOCRUZ_FLOWHIERARCHY_SNAPSHOT_VERSION 1
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \class FlowGraphSnapshot
+
+        \brief This class is used to save and load an imported flow graph to a binary file.
+
+        The file has a fixed size header followed by the graph columns, each one
+        stored as a raw array aligned to 8 bytes: vertex ids, coordinates and name
+        handles, the interned name table, edge origin/destiny, weight and distance,
+        the CSR adjacency in both directions and, if calculated, the statistics
+        and record count columns. The file is memory mapped on load and each column is copied in a
+        single block. The adjacency is not rebuilt, but the edge endpoints and the CSR offsets
+        are validated, and the name pool and vertex id index are rebuilt from their columns.
+
+        The file is written in the native byte order, a marker in the header is
+        used to reject files written in a different architecture.
+
+        The hierarchy index (see CalculateMainFlow::buildHierarchy) is saved in a separate
+        file with the same layout, it is meant to be kept next to the graph snapshot.
+        */
+        class FlowGraphSnapshot
+        {
+
+          public:
+
+            FlowGraphSnapshot();
+
+            ~FlowGraphSnapshot();
+
+          public:
+
+            /*!
+            \brief Writes a flow graph to a snapshot file.
+
+            \param graph      Flow graph, it must be built
+            \param fileName   Output file name
+
+            \exception te::common::Exception It throws an exception if the file can not be written.
+            */
+            void save(FlowGraph* graph, const std::string& fileName);
+
+            /*!
+            \brief Reads a flow graph from a snapshot file.
+
+            \param fileName   Input file name
+
+            \return A new flow graph, the caller takes the ownership.
+
+            \exception te::common::Exception It throws an exception if the file is not a valid snapshot.
+            */
+            FlowGraph* load(const std::string& fileName);
+
+            /*!
+            \brief Writes a hierarchy index to a file.
+
+            \param hierarchy   Hierarchy index built from the graph saved with save
+            \param fileName    Output file name
+
+            \exception te::common::Exception It throws an exception if the file can not be written.
+            */
+            void saveHierarchy(const FlowHierarchy& hierarchy, const std::string& fileName);
+
+            /*!
+            \brief Reads a hierarchy index from a file, only the lowest common pole table is rebuilt.
+
+            \param fileName   Input file name
+
+            \return A new hierarchy index, the caller takes the ownership. Its vertex count must match the graph one.
+
+            \exception te::common::Exception It throws an exception if the file is not a valid hierarchy file.
+            */
+            FlowHierarchy* loadHierarchy(const std::string& fileName);
+
+          protected:
+
+            /*!
+            \enum Section
+
+            \brief The sections of a snapshot file, in file order.
+            */
+            enum Section
+            {
+              SECTION_VERTEX_ID,
+              SECTION_VERTEX_X,
+              SECTION_VERTEX_Y,
+              SECTION_VERTEX_NAME,
+              SECTION_NAME_OFFSET,
+              SECTION_NAME_CHARS,
+              SECTION_EDGE_FROM,
+              SECTION_EDGE_TO,
+              SECTION_EDGE_WEIGHT,
+              SECTION_EDGE_DISTANCE,
+              SECTION_OUT_OFFSET,
+              SECTION_OUT_EDGE,
+              SECTION_IN_OFFSET,
+              SECTION_IN_EDGE,
+              SECTION_IN_FLOWS,
+              SECTION_OUT_FLOWS,
+              SECTION_SUM_IN,
+              SECTION_SUM_OUT,
+              SECTION_RECORD_COUNT,
+              SECTION_MEAN_IN,
+              SECTION_MEAN_OUT,
+              SECTION_MAX_IN,
+              SECTION_MAX_OUT,
+              SECTION_COUNT
+            };
+
+            /*!
+            \struct Header
+
+            \brief Fixed size header of a snapshot file.
+            */
+            struct Header
+            {
+              char m_magic[8];                                  //!< "FLOWSNAP"
+              boost::uint32_t m_version;                        //!< FIOCRUZ_FLOWGRAPH_SNAPSHOT_VERSION
+              boost::uint32_t m_byteOrder;                      //!< 0x01020304 in the writer byte order
+              boost::uint64_t m_vertexCount;
+              boost::uint64_t m_edgeCount;
+              boost::uint64_t m_nameCount;                      //!< Number of distinct names
+              boost::int32_t m_srid;
+              boost::uint32_t m_hasStatistics;
+              boost::uint32_t m_hasRecordCount;
+              boost::uint32_t m_hasExtendedStatistics;
+              boost::uint64_t m_sectionOffset[SECTION_COUNT];   //!< Offset of each section from the file begin
+              boost::uint64_t m_sectionSize[SECTION_COUNT];     //!< Size in bytes of each section
+            };
+
+            /*!
+            \enum HierarchySection
+
+            \brief The sections of a hierarchy file, in file order.
+            */
+            enum HierarchySection
+            {
+              HIERARCHY_SECTION_PARENT,
+              HIERARCHY_SECTION_ROOT,
+              HIERARCHY_SECTION_DEPTH,
+              HIERARCHY_SECTION_ROOTS,
+              HIERARCHY_SECTION_PREORDER,
+              HIERARCHY_SECTION_ENTER,
+              HIERARCHY_SECTION_EXIT,
+              HIERARCHY_SECTION_COUNT
+            };
+
+            /*!
+            \struct HierarchyHeader
+
+            \brief Fixed size header of a hierarchy file.
+            */
+            struct HierarchyHeader
+            {
+              char m_magic[8];                                            //!< "FLOWHIER"
+              boost::uint32_t m_version;                                  //!< FIOCRUZ_FLOWHIERARCHY_SNAPSHOT_VERSION
+              boost::uint32_t m_byteOrder;                                //!< 0x01020304 in the writer byte order
+              boost::uint64_t m_vertexCount;
+              boost::uint64_t m_rootCount;
+              boost::uint64_t m_sectionOffset[HIERARCHY_SECTION_COUNT];   //!< Offset of each section from the file begin
+              boost::uint64_t m_sectionSize[HIERARCHY_SECTION_COUNT];     //!< Size in bytes of each section
+            };
+
+            template<class H> void setSection(H& header, int section, boost::uint64_t size, boost::uint64_t& offset)
+            {
+              header.m_sectionOffset[section] = offset;
+              header.m_sectionSize[section] = size;
+
+              offset += (size + 7) & ~(boost::uint64_t)7;
+            }
+
+            template<class H> const char* getSection(const H& header, int section, const char* base, boost::uint64_t fileSize, boost::uint64_t expectedSize)
+            {
+              boost::uint64_t offset = header.m_sectionOffset[section];
+              boost::uint64_t size = header.m_sectionSize[section];
+
+              if (size != expectedSize || offset > fileSize || size > fileSize - offset)
+                throwInvalidFile();
+
+              return base + offset;
+            }
+
+            template<class H, class T> void copySection(const H& header, int section, const char* base, boost::uint64_t fileSize, std::size_t count, std::vector<T>& column)
+            {
+              //a count read from a corrupt header must not overflow the expected size
+              if (count > fileSize / sizeof(T))
+                throwInvalidFile();
+
+              const char* data = getSection(header, section, base, fileSize, (boost::uint64_t)count * sizeof(T));
+
+              const T* first = reinterpret_cast<const T*>(data);
+
+              column.assign(first, first + count);
+            }
+
+            /*! \brief Throws the exception used for a file with an invalid layout. */
+            void throwInvalidFile();
+
+        };
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_FLOWGRAPHSNAPSHOT_H
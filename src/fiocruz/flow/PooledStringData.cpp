@@ -0,0 +1,62 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/PooledStringData.cpp
+
+\brief This file defines a string attribute stored in a StringPool
+*/
+
+#include "PooledStringData.h"
+
+// TerraLib
+#include <terralib/datatype/Enums.h>
+#include <terralib/datatype/SimpleData.h>
+
+te::qt::plugins::fiocruz::PooledStringData::PooledStringData(const boost::shared_ptr<StringPool>& pool, boost::uint32_t handle)
+  : m_pool(pool),
+    m_handle(handle)
+{
+
+}
+
+te::qt::plugins::fiocruz::PooledStringData::~PooledStringData()
+{
+
+}
+
+te::dt::AbstractData* te::qt::plugins::fiocruz::PooledStringData::clone() const
+{
+  return new te::dt::SimpleData<std::string, te::dt::STRING_TYPE>(getValue());
+}
+
+int te::qt::plugins::fiocruz::PooledStringData::getTypeCode() const
+{
+  return te::dt::STRING_TYPE;
+}
+
+std::string te::qt::plugins::fiocruz::PooledStringData::toString() const
+{
+  return getValue();
+}
+
+const std::string& te::qt::plugins::fiocruz::PooledStringData::getValue() const
+{
+  return m_pool->get(m_handle);
+}
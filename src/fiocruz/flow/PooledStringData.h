@@ -0,0 +1,84 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/PooledStringData.h
+
+\brief This file defines a string attribute stored in a StringPool
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_POOLEDSTRINGDATA_H
+#define __FIOCRUZ_INTERNAL_FLOW_POOLEDSTRINGDATA_H
+
+// TerraLib
+#include <terralib/datatype/AbstractData.h>
+
+#include "../Config.h"
+#include "core/StringPool.h"
+
+// Boost
+#include <boost/shared_ptr.hpp>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \class PooledStringData
+
+        \brief String graph attribute that keeps only a handle to a shared StringPool.
+
+        It is used for the name attributes repeated in every edge, the string is
+        materialized only when the attribute is cloned (on export) or converted
+        with toString.
+        */
+        class PooledStringData : public te::dt::AbstractData
+        {
+          public:
+
+            PooledStringData(const boost::shared_ptr<StringPool>& pool, boost::uint32_t handle);
+
+            ~PooledStringData();
+
+          public:
+
+            /*! \brief Returns a te::dt::String with a copy of the pooled value. */
+            te::dt::AbstractData* clone() const;
+
+            int getTypeCode() const;
+
+            std::string toString() const;
+
+            const std::string& getValue() const;
+
+          protected:
+
+            boost::shared_ptr<StringPool> m_pool;   //!< Pool that owns the string
+            boost::uint32_t m_handle;               //!< String handle inside the pool
+        };
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_POOLEDSTRINGDATA_H
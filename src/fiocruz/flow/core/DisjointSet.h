@@ -0,0 +1,116 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/DisjointSet.h
+
+\brief This file defines a union-find structure over dense indexes
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_DISJOINTSET_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_DISJOINTSET_H
+
+#include "../../Config.h"
+
+// STL
+#include <algorithm>
+#include <vector>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \class DisjointSet
+
+        \brief Union-find over the dense indexes 0..N-1, with union by size and path compression.
+        */
+        class DisjointSet
+        {
+          public:
+
+            /*! \brief Creates n sets with one element each. */
+            DisjointSet(std::size_t n)
+              : m_parent(n),
+                m_size(n, 1)
+            {
+              for (std::size_t i = 0; i < n; ++i)
+                m_parent[i] = (int)i;
+            }
+
+            /*! \brief Returns the representative element of the set of i. */
+            int find(int i)
+            {
+              int root = i;
+
+              while (m_parent[root] != root)
+                root = m_parent[root];
+
+              //path compression, every element of the path points to the root
+              while (m_parent[i] != root)
+              {
+                int next = m_parent[i];
+                m_parent[i] = root;
+                i = next;
+              }
+
+              return root;
+            }
+
+            /*! \brief Joins the sets of a and b, returns the representative of the new set. */
+            int unite(int a, int b)
+            {
+              a = find(a);
+              b = find(b);
+
+              if (a == b)
+                return a;
+
+              if (m_size[a] < m_size[b])
+                std::swap(a, b);
+
+              m_parent[b] = a;
+              m_size[a] += m_size[b];
+
+              return a;
+            }
+
+            /*! \brief Returns the number of elements in the set of i. */
+            int getSize(int i)
+            {
+              return m_size[find(i)];
+            }
+
+          protected:
+
+            std::vector<int> m_parent;    //!< Parent of each element, a representative is its own parent
+            std::vector<int> m_size;      //!< Number of elements of each set, valid for the representatives
+        };
+
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_DISJOINTSET_H
@@ -0,0 +1,216 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/DistanceKernel.cpp
+
+\brief This file defines the batch distance functions used by the flow edges
+*/
+
+#include "DistanceKernel.h"
+#include "ParallelUtils.h"
+
+// STL
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  const double DEG_TO_RAD = 3.14159265358979323846 / 180.;
+
+  //mean earth radius (IUGG), in meters
+  const double EARTH_RADIUS = 6371008.8;
+
+  //WGS84 ellipsoid
+  const double WGS84_A = 6378137.;
+  const double WGS84_F = 1. / 298.257223563;
+  const double WGS84_B = (1. - WGS84_F) * WGS84_A;
+
+  //number of edges gathered at a time by each thread
+  const std::size_t DISTANCE_BLOCK_SIZE = 4096;
+
+  void PlanarDistances(const double* fromX, const double* fromY, const double* toX, const double* toY, std::size_t n, double* distances)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      double dx = toX[i] - fromX[i];
+      double dy = toY[i] - fromY[i];
+
+      distances[i] = dx * dx + dy * dy;
+    }
+
+    for (std::size_t i = 0; i < n; ++i)
+      distances[i] = std::sqrt(distances[i]);
+  }
+
+  double Haversine(double lon1, double lat1, double lon2, double lat2)
+  {
+    double sinLat = std::sin((lat2 - lat1) * DEG_TO_RAD / 2.);
+    double sinLon = std::sin((lon2 - lon1) * DEG_TO_RAD / 2.);
+
+    double a = sinLat * sinLat + std::cos(lat1 * DEG_TO_RAD) * std::cos(lat2 * DEG_TO_RAD) * sinLon * sinLon;
+
+    return 2. * EARTH_RADIUS * std::asin(std::sqrt(std::min(1., a)));
+  }
+
+  void HaversineDistances(const double* fromX, const double* fromY, const double* toX, const double* toY, std::size_t n, double* distances)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      distances[i] = Haversine(fromX[i], fromY[i], toX[i], toY[i]);
+  }
+
+  /*! \brief Inverse Vincenty formula, returns false if the iteration does not converge. */
+  bool Vincenty(double lon1, double lat1, double lon2, double lat2, double& distance)
+  {
+    double L = (lon2 - lon1) * DEG_TO_RAD;
+
+    double U1 = std::atan((1. - WGS84_F) * std::tan(lat1 * DEG_TO_RAD));
+    double U2 = std::atan((1. - WGS84_F) * std::tan(lat2 * DEG_TO_RAD));
+
+    double sinU1 = std::sin(U1);
+    double cosU1 = std::cos(U1);
+    double sinU2 = std::sin(U2);
+    double cosU2 = std::cos(U2);
+
+    double lambda = L;
+
+    double sinSigma = 0.;
+    double cosSigma = 0.;
+    double sigma = 0.;
+    double cos2Alpha = 0.;
+    double cos2SigmaM = 0.;
+
+    for (int iter = 0; iter < 100; ++iter)
+    {
+      double sinLambda = std::sin(lambda);
+      double cosLambda = std::cos(lambda);
+
+      double t1 = cosU2 * sinLambda;
+      double t2 = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+
+      sinSigma = std::sqrt(t1 * t1 + t2 * t2);
+
+      //coincident points
+      if (sinSigma == 0.)
+      {
+        distance = 0.;
+        return true;
+      }
+
+      cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+      sigma = std::atan2(sinSigma, cosSigma);
+
+      double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+
+      cos2Alpha = 1. - sinAlpha * sinAlpha;
+
+      //equatorial line
+      cos2SigmaM = cos2Alpha != 0. ? cosSigma - 2. * sinU1 * sinU2 / cos2Alpha : 0.;
+
+      double C = WGS84_F / 16. * cos2Alpha * (4. + WGS84_F * (4. - 3. * cos2Alpha));
+
+      double lambdaP = lambda;
+
+      lambda = L + (1. - C) * WGS84_F * sinAlpha * (sigma + C * sinSigma * (cos2SigmaM + C * cosSigma * (-1. + 2. * cos2SigmaM * cos2SigmaM)));
+
+      if (std::fabs(lambda - lambdaP) < 1e-12)
+      {
+        double uSq = cos2Alpha * (WGS84_A * WGS84_A - WGS84_B * WGS84_B) / (WGS84_B * WGS84_B);
+
+        double A = 1. + uSq / 16384. * (4096. + uSq * (-768. + uSq * (320. - 175. * uSq)));
+        double B = uSq / 1024. * (256. + uSq * (-128. + uSq * (74. - 47. * uSq)));
+
+        double deltaSigma = B * sinSigma * (cos2SigmaM + B / 4. * (cosSigma * (-1. + 2. * cos2SigmaM * cos2SigmaM) -
+                            B / 6. * cos2SigmaM * (-3. + 4. * sinSigma * sinSigma) * (-3. + 4. * cos2SigmaM * cos2SigmaM)));
+
+        distance = WGS84_B * A * (sigma - deltaSigma);
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void VincentyDistances(const double* fromX, const double* fromY, const double* toX, const double* toY, std::size_t n, double* distances)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (!Vincenty(fromX[i], fromY[i], toX[i], toY[i], distances[i]))
+        distances[i] = Haversine(fromX[i], fromY[i], toX[i], toY[i]);
+    }
+  }
+}
+
+void te::qt::plugins::fiocruz::CalculateDistances(const double* fromX, const double* fromY, const double* toX, const double* toY, std::size_t n, DistanceType type, double* distances)
+{
+  if (type == DISTANCE_HAVERSINE)
+    HaversineDistances(fromX, fromY, toX, toY, n, distances);
+  else if (type == DISTANCE_VINCENTY)
+    VincentyDistances(fromX, fromY, toX, toY, n, distances);
+  else
+    PlanarDistances(fromX, fromY, toX, toY, n, distances);
+}
+
+void te::qt::plugins::fiocruz::CalculateDistances(FlowGraph* graph, DistanceType type, std::size_t numThreads, std::size_t firstEdge)
+{
+  assert(graph);
+
+  const std::vector<double>& xs = graph->getVertexX();
+  const std::vector<double>& ys = graph->getVertexY();
+  const std::vector<int>& edgeFrom = graph->getEdgeFrom();
+  const std::vector<int>& edgeTo = graph->getEdgeTo();
+
+  std::vector<double>& distance = graph->getDistance();
+
+  std::size_t nEdges = graph->getEdgeCount();
+
+  if (firstEdge >= nEdges)
+    return;
+
+  ParallelFor(nEdges - firstEdge, numThreads, [&](std::size_t begin, std::size_t end, std::size_t)
+  {
+    std::vector<double> coords(4 * DISTANCE_BLOCK_SIZE);
+
+    double* fromX = &coords[0];
+    double* fromY = fromX + DISTANCE_BLOCK_SIZE;
+    double* toX = fromY + DISTANCE_BLOCK_SIZE;
+    double* toY = toX + DISTANCE_BLOCK_SIZE;
+
+    for (std::size_t block = firstEdge + begin; block < firstEdge + end; block += DISTANCE_BLOCK_SIZE)
+    {
+      std::size_t n = std::min(DISTANCE_BLOCK_SIZE, firstEdge + end - block);
+
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        int from = edgeFrom[block + i];
+        int to = edgeTo[block + i];
+
+        fromX[i] = xs[from];
+        fromY[i] = ys[from];
+        toX[i] = xs[to];
+        toY[i] = ys[to];
+      }
+
+      CalculateDistances(fromX, fromY, toX, toY, n, type, &distance[block]);
+    }
+  });
+}
@@ -0,0 +1,82 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/DistanceKernel.h
+
+\brief This file defines the batch distance functions used by the flow edges
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_DISTANCEKERNEL_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_DISTANCEKERNEL_H
+
+#include "../../Config.h"
+#include "FlowGraph.h"
+
+// STL
+#include <cstddef>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \enum DistanceType
+
+        \brief Metric used to calculate the distance between the origin and the destiny of a flow.
+        */
+        enum DistanceType
+        {
+          DISTANCE_PLANAR,      //!< Euclidean distance in the coordinate units
+          DISTANCE_HAVERSINE,   //!< Great circle distance in meters, the coordinates are longitude / latitude degrees
+          DISTANCE_VINCENTY     //!< Distance on the WGS84 ellipsoid in meters, the coordinates are longitude / latitude degrees
+        };
+
+        /*!
+        \brief Calculates the distance between the points (fromX[i], fromY[i]) and (toX[i], toY[i]) of n point pairs.
+
+        The coordinates are read as separated arrays and each metric is a simple loop
+        over them, without any virtual call, so the compiler can vectorize the
+        arithmetic. For DISTANCE_VINCENTY the pairs where the iteration does not converge
+        (nearly antipodal points) get the haversine distance.
+
+        \param distances   Output array with n values, it may not overlap the inputs
+        */
+        void CalculateDistances(const double* fromX, const double* fromY, const double* toX, const double* toY, std::size_t n, DistanceType type, double* distances);
+
+        /*!
+        \brief Fills the distance column of the edges [firstEdge, edge count) of a graph from its vertex coordinates.
+
+        The edge coordinates are gathered in blocks by each thread and passed to the
+        array version.
+
+        \param numThreads   Number of threads, 0 uses one thread per core (see GetThreadCount)
+        */
+        void CalculateDistances(FlowGraph* graph, DistanceType type, std::size_t numThreads, std::size_t firstEdge = 0);
+
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_DISTANCEKERNEL_H
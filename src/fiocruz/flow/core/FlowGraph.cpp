@@ -0,0 +1,511 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/FlowGraph.cpp
+
+\brief This file defines the in-memory Flow Graph class
+*/
+
+#include "FlowGraph.h"
+
+// STL
+#include <cassert>
+
+te::qt::plugins::fiocruz::FlowGraph::FlowGraph()
+{
+  m_namePool.reset(new StringPool());
+
+  m_srid = 0;
+  m_built = false;
+  m_hasStatistics = false;
+  m_hasExtendedStatistics = false;
+  m_hasDominance = false;
+  m_hasDominanceModes = false;
+  m_hasMainFlow = false;
+  m_hasMainFlowStatistics = false;
+  m_hasFlowRank = false;
+  m_hasRecordCount = false;
+}
+
+te::qt::plugins::fiocruz::FlowGraph::~FlowGraph()
+{
+
+}
+
+int te::qt::plugins::fiocruz::FlowGraph::addVertex(int id, const std::string& name, double x, double y)
+{
+  bool added;
+
+  int idx = m_vertexIndex.add(id, added);
+
+  if (!added)
+    return idx;
+
+  m_vertexId.push_back(id);
+  m_vertexName.push_back(m_namePool->add(name));
+  m_vertexX.push_back(x);
+  m_vertexY.push_back(y);
+
+  m_built = false;
+
+  return idx;
+}
+
+int te::qt::plugins::fiocruz::FlowGraph::addEdge(int from, int to, double weight, double distance)
+{
+  assert(from >= 0 && from < (int)m_vertexId.size());
+  assert(to >= 0 && to < (int)m_vertexId.size());
+
+  int idx = (int)m_edgeFrom.size();
+
+  m_edgeFrom.push_back(from);
+  m_edgeTo.push_back(to);
+  m_weight.push_back(weight);
+  m_distance.push_back(distance);
+
+  m_built = false;
+
+  return idx;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::addEdgeWeight(int edge, double weight)
+{
+  assert(edge >= 0 && edge < (int)m_edgeFrom.size());
+
+  m_weight[edge] += weight;
+
+  if (m_hasRecordCount)
+    m_recordCount[edge] += 1;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::build()
+{
+  std::size_t nVertex = m_vertexId.size();
+  std::size_t nEdge = m_edgeFrom.size();
+
+  resizeColumns();
+
+  //count the degree of each vertex
+  m_outOffset.assign(nVertex + 1, 0);
+  m_inOffset.assign(nVertex + 1, 0);
+
+  for (std::size_t e = 0; e < nEdge; ++e)
+  {
+    ++m_outOffset[m_edgeFrom[e] + 1];
+    ++m_inOffset[m_edgeTo[e] + 1];
+  }
+
+  for (std::size_t v = 0; v < nVertex; ++v)
+  {
+    m_outOffset[v + 1] += m_outOffset[v];
+    m_inOffset[v + 1] += m_inOffset[v];
+  }
+
+  //fill edge lists, the edges of each vertex stay sorted by edge index
+  m_outEdge.resize(nEdge);
+  m_inEdge.resize(nEdge);
+
+  std::vector<int> outPos(m_outOffset.begin(), m_outOffset.end() - 1);
+  std::vector<int> inPos(m_inOffset.begin(), m_inOffset.end() - 1);
+
+  for (std::size_t e = 0; e < nEdge; ++e)
+  {
+    m_outEdge[outPos[m_edgeFrom[e]]++] = (int)e;
+    m_inEdge[inPos[m_edgeTo[e]]++] = (int)e;
+  }
+
+  m_built = true;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::resizeColumns()
+{
+  std::size_t nVertex = m_vertexId.size();
+  std::size_t nEdge = m_edgeFrom.size();
+
+  if (m_hasStatistics)
+  {
+    m_inFlows.resize(nVertex, 0);
+    m_outFlows.resize(nVertex, 0);
+    m_sumIn.resize(nVertex, 0.);
+    m_sumOut.resize(nVertex, 0.);
+  }
+
+  if (m_hasExtendedStatistics)
+  {
+    m_meanIn.resize(nVertex, 0.);
+    m_meanOut.resize(nVertex, 0.);
+    m_maxIn.resize(nVertex, 0.);
+    m_maxOut.resize(nVertex, 0.);
+  }
+
+  if (m_hasDominance)
+    m_dominance.resize(nVertex, 0.);
+
+  if (m_hasDominanceModes)
+  {
+    for (int t = 0; t < DOMINANCE_TYPE_COUNT; ++t)
+      m_dominanceMode[t].resize(nVertex, 0.);
+  }
+
+  if (m_hasMainFlow)
+  {
+    m_mainFlow.resize(nEdge, 0);
+    m_level.resize(nVertex, -1);
+  }
+
+  if (m_hasMainFlowStatistics)
+  {
+    m_destiny.resize(nVertex, -1);
+    m_tree.resize(nVertex, -1);
+    m_input.resize(nVertex, -1);
+  }
+
+  if (m_hasFlowRank)
+  {
+    m_flowRank.resize(nEdge, 0);
+    m_flowShare.resize(nEdge, 0.);
+  }
+
+  if (m_hasRecordCount)
+    m_recordCount.resize(nEdge, 1);
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::isBuilt() const
+{
+  return m_built;
+}
+
+int te::qt::plugins::fiocruz::FlowGraph::getVertexIndex(int id) const
+{
+  return m_vertexIndex.getIndex(id);
+}
+
+std::size_t te::qt::plugins::fiocruz::FlowGraph::getVertexCount() const
+{
+  return m_vertexId.size();
+}
+
+std::size_t te::qt::plugins::fiocruz::FlowGraph::getEdgeCount() const
+{
+  return m_edgeFrom.size();
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::setSRID(int srid)
+{
+  m_srid = srid;
+}
+
+int te::qt::plugins::fiocruz::FlowGraph::getSRID() const
+{
+  return m_srid;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::initStatistics(bool addExtendedColumns)
+{
+  std::size_t nVertex = m_vertexId.size();
+
+  m_inFlows.assign(nVertex, 0);
+  m_outFlows.assign(nVertex, 0);
+  m_sumIn.assign(nVertex, 0.);
+  m_sumOut.assign(nVertex, 0.);
+
+  if (addExtendedColumns)
+  {
+    m_meanIn.assign(nVertex, 0.);
+    m_meanOut.assign(nVertex, 0.);
+    m_maxIn.assign(nVertex, 0.);
+    m_maxOut.assign(nVertex, 0.);
+  }
+  else
+  {
+    m_meanIn.clear();
+    m_meanOut.clear();
+    m_maxIn.clear();
+    m_maxOut.clear();
+  }
+
+  m_hasStatistics = true;
+  m_hasExtendedStatistics = addExtendedColumns;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::initDominance()
+{
+  m_dominance.assign(m_vertexId.size(), 0.);
+
+  m_hasDominance = true;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::initDominanceModes()
+{
+  for (int t = 0; t < DOMINANCE_TYPE_COUNT; ++t)
+    m_dominanceMode[t].assign(m_vertexId.size(), 0.);
+
+  m_hasDominanceModes = true;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::setDominanceType(DominanceType type)
+{
+  assert(m_hasDominanceModes);
+
+  m_dominance = m_dominanceMode[type];
+
+  m_hasDominance = true;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::initMainFlow(bool addStatisticsColumns)
+{
+  std::size_t nVertex = m_vertexId.size();
+
+  m_mainFlow.assign(m_edgeFrom.size(), 0);
+  m_level.assign(nVertex, -1);
+
+  if (addStatisticsColumns)
+  {
+    m_destiny.assign(nVertex, -1);
+    m_tree.assign(nVertex, -1);
+    m_input.assign(nVertex, -1);
+  }
+
+  m_hasMainFlow = true;
+  m_hasMainFlowStatistics = addStatisticsColumns;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::initFlowRank()
+{
+  m_flowRank.assign(m_edgeFrom.size(), 0);
+  m_flowShare.assign(m_edgeFrom.size(), 0.);
+
+  m_hasFlowRank = true;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::clearFlowRank()
+{
+  m_flowRank.clear();
+  m_flowShare.clear();
+
+  m_hasFlowRank = false;
+}
+
+void te::qt::plugins::fiocruz::FlowGraph::initRecordCount()
+{
+  m_recordCount.assign(m_edgeFrom.size(), 1);
+
+  m_hasRecordCount = true;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasStatistics() const
+{
+  return m_hasStatistics;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasExtendedStatistics() const
+{
+  return m_hasExtendedStatistics;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasDominance() const
+{
+  return m_hasDominance;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasDominanceModes() const
+{
+  return m_hasDominanceModes;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasMainFlow() const
+{
+  return m_hasMainFlow;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasMainFlowStatistics() const
+{
+  return m_hasMainFlowStatistics;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasFlowRank() const
+{
+  return m_hasFlowRank;
+}
+
+bool te::qt::plugins::fiocruz::FlowGraph::hasRecordCount() const
+{
+  return m_hasRecordCount;
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getVertexIds() const
+{
+  return m_vertexId;
+}
+
+const std::vector<boost::uint32_t>& te::qt::plugins::fiocruz::FlowGraph::getVertexNameHandles() const
+{
+  return m_vertexName;
+}
+
+const std::string& te::qt::plugins::fiocruz::FlowGraph::getVertexName(std::size_t v) const
+{
+  return m_namePool->get(m_vertexName[v]);
+}
+
+const std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getVertexX() const
+{
+  return m_vertexX;
+}
+
+const std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getVertexY() const
+{
+  return m_vertexY;
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getInFlows()
+{
+  return m_inFlows;
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getOutFlows()
+{
+  return m_outFlows;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getSumIn()
+{
+  return m_sumIn;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getSumOut()
+{
+  return m_sumOut;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getMeanIn()
+{
+  return m_meanIn;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getMeanOut()
+{
+  return m_meanOut;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getMaxIn()
+{
+  return m_maxIn;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getMaxOut()
+{
+  return m_maxOut;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getDominance()
+{
+  return m_dominance;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getDominance(DominanceType type)
+{
+  return m_dominanceMode[type];
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getLevel()
+{
+  return m_level;
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getDestiny()
+{
+  return m_destiny;
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getTree()
+{
+  return m_tree;
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getInput()
+{
+  return m_input;
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getEdgeFrom() const
+{
+  return m_edgeFrom;
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getEdgeTo() const
+{
+  return m_edgeTo;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getWeight()
+{
+  return m_weight;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getDistance()
+{
+  return m_distance;
+}
+
+std::vector<unsigned char>& te::qt::plugins::fiocruz::FlowGraph::getMainFlow()
+{
+  return m_mainFlow;
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getFlowRank()
+{
+  return m_flowRank;
+}
+
+std::vector<double>& te::qt::plugins::fiocruz::FlowGraph::getFlowShare()
+{
+  return m_flowShare;
+}
+
+std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getRecordCount()
+{
+  return m_recordCount;
+}
+
+boost::shared_ptr<te::qt::plugins::fiocruz::StringPool> te::qt::plugins::fiocruz::FlowGraph::getNamePool() const
+{
+  return m_namePool;
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getOutOffsets() const
+{
+  return m_outOffset;
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getOutEdges() const
+{
+  return m_outEdge;
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getInOffsets() const
+{
+  return m_inOffset;
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowGraph::getInEdges() const
+{
+  return m_inEdge;
+}
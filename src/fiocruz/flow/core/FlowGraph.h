@@ -0,0 +1,291 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/FlowGraph.h
+
+\brief This file defines the in-memory Flow Graph class
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWGRAPH_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWGRAPH_H
+
+#include "../../Config.h"
+#include "IdDictionary.h"
+#include "StringPool.h"
+
+// STL
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \enum DominanceType
+
+        \brief Flow sum used as the dominance of a vertex.
+        */
+        enum DominanceType
+        {
+          DOMINANCE_INPUTFLOW,    //!< Sum of the input flows
+          DOMINANCE_OUTPUTFLOW,   //!< Sum of the output flows
+          DOMINANCE_NETFLOW,      //!< Input minus output flows
+          DOMINANCE_TOTALFLOW,    //!< Input plus output flows
+          DOMINANCE_TYPE_COUNT
+        };
+
+        /*!
+        \class FlowGraph
+
+        \brief Compact directed graph used by the flow pipeline.
+
+        Vertices and edges are addressed by dense indices (0..N-1). Every attribute
+        is kept as a column (one std::vector per attribute) and the adjacency is
+        stored in CSR form (offset + edge index arrays) for both directions.
+
+        The external vertex id (the one read from the input data) is kept in the
+        id column and is only used again when the graph is exported. It is a 32 bits
+        integer, the readers reject id columns with other values (see ColumnReader::getId). The edge
+        index is also the edge id used on export.
+
+        The graph is filled using addVertex / addEdge and must be finalized with
+        build() before any adjacency information is requested.
+        */
+        class FlowGraph
+        {
+          friend class FlowGraphSnapshot;
+
+          public:
+
+            FlowGraph();
+
+            ~FlowGraph();
+
+          public:
+
+            /*!
+            \brief Adds a new vertex to the graph.
+
+            \param id     External vertex id
+            \param name   Vertex name
+            \param x      Vertex x coordinate
+            \param y      Vertex y coordinate
+
+            \return The dense index of the new vertex, or the index of the existing vertex with the same id.
+            */
+            int addVertex(int id, const std::string& name, double x, double y);
+
+            /*!
+            \brief Adds a new edge to the graph.
+
+            \param from       Dense index of the origin vertex
+            \param to         Dense index of the destiny vertex
+            \param weight     Flow value
+            \param distance   Distance between origin and destiny
+
+            \return The dense index of the new edge.
+            */
+            int addEdge(int from, int to, double weight, double distance);
+
+            /*!
+            \brief Builds the CSR adjacency from the edge list.
+
+            The calculated columns are extended to the vertices and edges added after
+            they were initialized, with the same value used by the init functions.
+            */
+            void build();
+
+            /*! \brief Returns true if the CSR adjacency is up to date. */
+            bool isBuilt() const;
+
+            /*! \brief Adds a value to the weight of an existing edge (and one to its record count, if present). */
+            void addEdgeWeight(int edge, double weight);
+
+            /*! \brief Returns the dense index of the vertex with the given external id or -1. */
+            int getVertexIndex(int id) const;
+
+            std::size_t getVertexCount() const;
+
+            std::size_t getEdgeCount() const;
+
+            void setSRID(int srid);
+
+            int getSRID() const;
+
+          public:
+
+            /*! \brief Resets the statistics columns (in_flows, out_flows, sum_in, sum_out and, if requested, mean_in, mean_out, max_in, max_out). */
+            void initStatistics(bool addExtendedColumns = false);
+
+            /*! \brief Resets the dominance column with 0 value. */
+            void initDominance();
+
+            /*! \brief Resets the dominance columns of all dominance types with 0 value. */
+            void initDominanceModes();
+
+            /*! \brief Copies the column of a dominance type to the dominance column used by the main flow. */
+            void setDominanceType(DominanceType type);
+
+            /*! \brief Resets the main flow column with 0 and the level column with -1. */
+            void initMainFlow(bool addStatisticsColumns);
+
+            /*! \brief Resets the flow rank column with 0 (not ranked) and the flow share column with 0. */
+            void initFlowRank();
+
+            /*! \brief Removes the flow rank and flow share columns. */
+            void clearFlowRank();
+
+            /*! \brief Resets the record count column with 1 (each edge is one input record). */
+            void initRecordCount();
+
+            bool hasStatistics() const;
+
+            bool hasExtendedStatistics() const;
+
+            bool hasDominance() const;
+
+            bool hasDominanceModes() const;
+
+            bool hasMainFlow() const;
+
+            bool hasMainFlowStatistics() const;
+
+            bool hasFlowRank() const;
+
+            bool hasRecordCount() const;
+
+          public:
+
+            //vertex columns
+            const std::vector<int>& getVertexIds() const;
+            const std::vector<boost::uint32_t>& getVertexNameHandles() const;
+            const std::string& getVertexName(std::size_t v) const;
+            const std::vector<double>& getVertexX() const;
+            const std::vector<double>& getVertexY() const;
+
+            std::vector<int>& getInFlows();
+            std::vector<int>& getOutFlows();
+            std::vector<double>& getSumIn();
+            std::vector<double>& getSumOut();
+            std::vector<double>& getMeanIn();
+            std::vector<double>& getMeanOut();
+            std::vector<double>& getMaxIn();
+            std::vector<double>& getMaxOut();
+            std::vector<double>& getDominance();
+            std::vector<double>& getDominance(DominanceType type);
+            std::vector<int>& getLevel();
+            std::vector<int>& getDestiny();
+            std::vector<int>& getTree();
+            std::vector<int>& getInput();
+
+            //edge columns
+            const std::vector<int>& getEdgeFrom() const;
+            const std::vector<int>& getEdgeTo() const;
+            std::vector<double>& getWeight();
+            std::vector<double>& getDistance();
+            std::vector<unsigned char>& getMainFlow();
+            std::vector<int>& getFlowRank();
+            std::vector<double>& getFlowShare();
+            std::vector<int>& getRecordCount();
+
+            /*! \brief Returns the pool with the vertex names, it may be shared with the exported attributes. */
+            boost::shared_ptr<StringPool> getNamePool() const;
+
+            //adjacency (valid after build)
+            const std::vector<int>& getOutOffsets() const;
+            const std::vector<int>& getOutEdges() const;
+            const std::vector<int>& getInOffsets() const;
+            const std::vector<int>& getInEdges() const;
+
+          protected:
+
+            /*! \brief Resizes the calculated columns that are present to the current number of vertices and edges. */
+            void resizeColumns();
+
+          protected:
+
+            //vertex columns
+            std::vector<int> m_vertexId;              //!< External vertex id
+            std::vector<boost::uint32_t> m_vertexName;  //!< Vertex name handle inside m_namePool
+            std::vector<double> m_vertexX;            //!< Vertex x coordinate
+            std::vector<double> m_vertexY;            //!< Vertex y coordinate
+
+            std::vector<int> m_inFlows;               //!< Number of input flows
+            std::vector<int> m_outFlows;              //!< Number of output flows
+            std::vector<double> m_sumIn;              //!< Sum of input flow values
+            std::vector<double> m_sumOut;             //!< Sum of output flow values
+            std::vector<double> m_meanIn;             //!< Mean of input flow values
+            std::vector<double> m_meanOut;            //!< Mean of output flow values
+            std::vector<double> m_maxIn;              //!< Greatest input flow value
+            std::vector<double> m_maxOut;             //!< Greatest output flow value
+            std::vector<double> m_dominance;          //!< Dominance value
+            std::vector<double> m_dominanceMode[DOMINANCE_TYPE_COUNT];  //!< Dominance value of each dominance type
+            std::vector<int> m_level;                 //!< Hierarchy level (-1 if not reached)
+            std::vector<int> m_destiny;               //!< Immediately superior vertex (external id)
+            std::vector<int> m_tree;                  //!< Number of vertices in the tree of a root
+            std::vector<int> m_input;                 //!< Number of children of a vertex
+
+            //edge columns
+            std::vector<int> m_edgeFrom;              //!< Dense index of the origin vertex
+            std::vector<int> m_edgeTo;                //!< Dense index of the destiny vertex
+            std::vector<double> m_weight;             //!< Flow value
+            std::vector<double> m_distance;           //!< Distance value
+            std::vector<unsigned char> m_mainFlow;    //!< 1 if the edge is the main flow of its origin
+            std::vector<int> m_flowRank;              //!< Position of the edge among the heaviest output edges of its origin (1 is the main flow), 0 if not ranked
+            std::vector<double> m_flowShare;          //!< Edge weight divided by the sum of the output weights of its origin
+            std::vector<int> m_recordCount;           //!< Number of input records merged in the edge
+
+            //adjacency
+            std::vector<int> m_outOffset;             //!< CSR offsets of output edges (size N+1)
+            std::vector<int> m_outEdge;               //!< Output edge indexes grouped by origin
+            std::vector<int> m_inOffset;              //!< CSR offsets of input edges (size N+1)
+            std::vector<int> m_inEdge;                //!< Input edge indexes grouped by destiny
+
+            IdDictionary<int> m_vertexIndex;          //!< External id to dense index
+
+            boost::shared_ptr<StringPool> m_namePool; //!< Distinct vertex names
+
+            int m_srid;                               //!< Coordinates projection id
+
+            bool m_built;                             //!< Adjacency status
+            bool m_hasStatistics;                     //!< Statistics columns were calculated
+            bool m_hasExtendedStatistics;             //!< Mean and max statistics columns were calculated
+            bool m_hasDominance;                      //!< Dominance column was calculated
+            bool m_hasDominanceModes;                 //!< Dominance columns of all types were calculated
+            bool m_hasMainFlow;                       //!< Main flow and level columns were calculated
+            bool m_hasMainFlowStatistics;             //!< Destiny, tree and input columns were requested
+            bool m_hasFlowRank;                       //!< Flow rank and share columns were calculated
+            bool m_hasRecordCount;                    //!< Edges were aggregated from input records
+        };
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWGRAPH_H
@@ -0,0 +1,254 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/FlowHierarchy.cpp
+
+\brief This file defines a compact index of the regional hierarchy built from the main flows
+*/
+
+#include "FlowHierarchy.h"
+
+// STL
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+te::qt::plugins::fiocruz::FlowHierarchy::FlowHierarchy()
+{
+
+}
+
+te::qt::plugins::fiocruz::FlowHierarchy::~FlowHierarchy()
+{
+
+}
+
+void te::qt::plugins::fiocruz::FlowHierarchy::build(const std::vector<int>& parent)
+{
+  std::size_t nVertex = parent.size();
+
+  m_parent = parent;
+  m_roots.clear();
+
+  //children in CSR form, in vertex order
+  std::vector<int> childOffset(nVertex + 1, 0);
+
+  for (std::size_t v = 0; v < nVertex; ++v)
+  {
+    if (parent[v] == -1)
+      m_roots.push_back((int)v);
+    else
+      ++childOffset[parent[v] + 1];
+  }
+
+  for (std::size_t v = 0; v < nVertex; ++v)
+    childOffset[v + 1] += childOffset[v];
+
+  std::vector<int> children(childOffset[nVertex]);
+  std::vector<int> next(childOffset.begin(), childOffset.end() - 1);
+
+  for (std::size_t v = 0; v < nVertex; ++v)
+  {
+    if (parent[v] != -1)
+      children[next[parent[v]]++] = (int)v;
+  }
+
+  m_root.assign(nVertex, -1);
+  m_depth.assign(nVertex, 0);
+  m_enter.assign(nVertex, 0);
+  m_exit.assign(nVertex, 0);
+  m_preorder.clear();
+  m_preorder.reserve(nVertex);
+
+  //iterative depth first search, the stack keeps the vertex and its next child
+  std::vector<std::pair<int, int> > stack;
+
+  for (std::size_t r = 0; r < m_roots.size(); ++r)
+  {
+    int root = m_roots[r];
+
+    m_root[root] = root;
+    m_enter[root] = (int)m_preorder.size();
+    m_preorder.push_back(root);
+
+    stack.push_back(std::make_pair(root, childOffset[root]));
+
+    while (!stack.empty())
+    {
+      int vertex = stack.back().first;
+      int& child = stack.back().second;
+
+      if (child == childOffset[vertex + 1])
+      {
+        m_exit[vertex] = (int)m_preorder.size();
+        stack.pop_back();
+        continue;
+      }
+
+      int vCur = children[child++];
+
+      m_root[vCur] = root;
+      m_depth[vCur] = m_depth[vertex] + 1;
+      m_enter[vCur] = (int)m_preorder.size();
+      m_preorder.push_back(vCur);
+
+      stack.push_back(std::make_pair(vCur, childOffset[vCur]));
+    }
+  }
+
+  assert(m_preorder.size() == nVertex);
+
+  buildSparseTable();
+}
+
+std::size_t te::qt::plugins::fiocruz::FlowHierarchy::getVertexCount() const
+{
+  return m_parent.size();
+}
+
+int te::qt::plugins::fiocruz::FlowHierarchy::getParent(int vertex) const
+{
+  return m_parent[vertex];
+}
+
+int te::qt::plugins::fiocruz::FlowHierarchy::getRoot(int vertex) const
+{
+  return m_root[vertex];
+}
+
+int te::qt::plugins::fiocruz::FlowHierarchy::getDepth(int vertex) const
+{
+  return m_depth[vertex];
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowHierarchy::getRoots() const
+{
+  return m_roots;
+}
+
+bool te::qt::plugins::fiocruz::FlowHierarchy::isUnder(int vertex, int ancestor) const
+{
+  return m_enter[ancestor] <= m_enter[vertex] && m_enter[vertex] < m_exit[ancestor];
+}
+
+std::size_t te::qt::plugins::fiocruz::FlowHierarchy::getSubtreeSize(int vertex) const
+{
+  return (std::size_t)(m_exit[vertex] - m_enter[vertex]);
+}
+
+void te::qt::plugins::fiocruz::FlowHierarchy::getSubtree(int vertex, std::vector<int>& vertices) const
+{
+  vertices.assign(m_preorder.begin() + m_enter[vertex], m_preorder.begin() + m_exit[vertex]);
+}
+
+void te::qt::plugins::fiocruz::FlowHierarchy::getPathToRoot(int vertex, std::vector<int>& path) const
+{
+  path.clear();
+  path.reserve(m_depth[vertex] + 1);
+
+  for (int v = vertex; v != -1; v = m_parent[v])
+    path.push_back(v);
+}
+
+int te::qt::plugins::fiocruz::FlowHierarchy::getLowestCommonPole(int a, int b) const
+{
+  if (m_root[a] != m_root[b])
+    return -1;
+
+  if (isUnder(b, a))
+    return a;
+
+  if (isUnder(a, b))
+    return b;
+
+  int first = m_enter[a];
+  int last = m_enter[b];
+
+  if (first > last)
+    std::swap(first, last);
+
+  //the shallowest vertex after a and up to b in preorder is a child of the common pole
+  return m_parent[m_preorder[getMinDepthPosition(first + 1, last)]];
+}
+
+const std::vector<int>& te::qt::plugins::fiocruz::FlowHierarchy::getPreorder() const
+{
+  return m_preorder;
+}
+
+int te::qt::plugins::fiocruz::FlowHierarchy::getEnter(int vertex) const
+{
+  return m_enter[vertex];
+}
+
+int te::qt::plugins::fiocruz::FlowHierarchy::getExit(int vertex) const
+{
+  return m_exit[vertex];
+}
+
+void te::qt::plugins::fiocruz::FlowHierarchy::buildSparseTable()
+{
+  std::size_t n = m_preorder.size();
+
+  m_sparseTable.clear();
+
+  if (n == 0)
+    return;
+
+  m_sparseTable.push_back(std::vector<int>(n));
+
+  for (std::size_t i = 0; i < n; ++i)
+    m_sparseTable[0][i] = (int)i;
+
+  for (std::size_t k = 1; ((std::size_t)1 << k) <= n; ++k)
+  {
+    std::size_t half = (std::size_t)1 << (k - 1);
+    std::size_t count = n - ((std::size_t)1 << k) + 1;
+
+    const std::vector<int>& prev = m_sparseTable[k - 1];
+
+    std::vector<int> level(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      int left = prev[i];
+      int right = prev[i + half];
+
+      level[i] = m_depth[m_preorder[right]] < m_depth[m_preorder[left]] ? right : left;
+    }
+
+    m_sparseTable.push_back(level);
+  }
+}
+
+int te::qt::plugins::fiocruz::FlowHierarchy::getMinDepthPosition(int first, int last) const
+{
+  std::size_t length = (std::size_t)(last - first + 1);
+
+  std::size_t k = 0;
+
+  while (((std::size_t)2 << k) <= length)
+    ++k;
+
+  int left = m_sparseTable[k][first];
+  int right = m_sparseTable[k][last - ((int)1 << k) + 1];
+
+  return m_depth[m_preorder[right]] < m_depth[m_preorder[left]] ? right : left;
+}
@@ -0,0 +1,135 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/FlowHierarchy.h
+
+\brief This file defines a compact index of the regional hierarchy built from the main flows
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWHIERARCHY_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWHIERARCHY_H
+
+#include "../../Config.h"
+
+// STL
+#include <vector>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \class FlowHierarchy
+
+        \brief Compact index of the forest formed by the superior links of the main flow.
+
+        Each vertex (dense graph index) has a parent (its superior or -1 for a pole at
+        the top of a tree). The forest is stored as a parent array, the list of top poles
+        and a preorder (Euler tour) encoding: the vertices under a pole are the preorder
+        positions [enter, exit) of the pole, so descendant tests are O(1) and the members
+        of a region are a contiguous block. The lowest common pole is answered in O(1)
+        with a sparse table over the preorder depths.
+        */
+        class FlowHierarchy
+        {
+          friend class FlowGraphSnapshot;
+
+          public:
+
+            FlowHierarchy();
+
+            ~FlowHierarchy();
+
+          public:
+
+            /*!
+            \brief Builds the index from a parent array.
+
+            \param parent   Parent of each vertex or -1, the links must not have cycles
+            */
+            void build(const std::vector<int>& parent);
+
+            std::size_t getVertexCount() const;
+
+            /*! \brief Returns the parent of a vertex or -1 if it is a top pole. */
+            int getParent(int vertex) const;
+
+            /*! \brief Returns the top pole of the tree of a vertex (the vertex itself for a top pole). */
+            int getRoot(int vertex) const;
+
+            /*! \brief Returns the number of links from a vertex to its top pole. */
+            int getDepth(int vertex) const;
+
+            /*! \brief Returns the top poles, in vertex order. */
+            const std::vector<int>& getRoots() const;
+
+            /*! \brief Returns true if ancestor is the vertex itself or one of its superiors. */
+            bool isUnder(int vertex, int ancestor) const;
+
+            /*! \brief Returns the number of vertices under a pole, the pole included. */
+            std::size_t getSubtreeSize(int vertex) const;
+
+            /*! \brief Fills vertices with the pole and all vertices under it, in preorder. */
+            void getSubtree(int vertex, std::vector<int>& vertices) const;
+
+            /*! \brief Fills path with the vertex and its superiors up to the top pole. */
+            void getPathToRoot(int vertex, std::vector<int>& path) const;
+
+            /*! \brief Returns the lowest pole that has both vertices under it, or -1 if they are in different trees. */
+            int getLowestCommonPole(int a, int b) const;
+
+            /*! \brief Returns the vertices in preorder, the subtree of v is [getEnter(v), getExit(v)). */
+            const std::vector<int>& getPreorder() const;
+
+            int getEnter(int vertex) const;
+
+            int getExit(int vertex) const;
+
+          protected:
+
+            /*! \brief Builds the sparse table used by the lowest common pole queries from the preorder and depth columns. */
+            void buildSparseTable();
+
+            /*! \brief Returns the position in [first, last] of the preorder vertex with the lowest depth. */
+            int getMinDepthPosition(int first, int last) const;
+
+          protected:
+
+            std::vector<int> m_parent;      //!< Parent of each vertex or -1
+            std::vector<int> m_root;        //!< Top pole of the tree of each vertex
+            std::vector<int> m_depth;       //!< Depth of each vertex, 0 for a top pole
+            std::vector<int> m_roots;       //!< Top poles, in vertex order
+            std::vector<int> m_preorder;    //!< Vertices in preorder, each tree is a contiguous block
+            std::vector<int> m_enter;       //!< Preorder position of each vertex
+            std::vector<int> m_exit;        //!< Preorder position after the last vertex under each vertex
+
+            std::vector<std::vector<int> > m_sparseTable;   //!< Level k keeps the min depth position of each preorder range of size 2^k
+        };
+
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWHIERARCHY_H
@@ -0,0 +1,339 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/FlowPairAggregator.cpp
+
+\brief This file defines a class used to merge flow records with the same origin and destiny
+*/
+
+#include "FlowPairAggregator.h"
+
+// TerraLib
+#include <terralib/common/Exception.h>
+#include <terralib/common/Translator.h>
+
+// STL
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+// Boost
+#include <boost/filesystem.hpp>
+
+namespace
+{
+  //maximum number of runs open at the same time, more runs are merged in passes
+  const std::size_t MERGE_FAN_IN = 64;
+}
+
+te::qt::plugins::fiocruz::FlowPairAggregator::FlowPairAggregator(std::size_t maxPairs)
+{
+  m_maxPairs = maxPairs > 0 ? maxPairs : 1;
+  m_nextPair = 0;
+  m_finished = false;
+}
+
+te::qt::plugins::fiocruz::FlowPairAggregator::~FlowPairAggregator()
+{
+  for (std::size_t t = 0; t < m_runs.size(); ++t)
+  {
+    m_runs[t].m_stream.reset();
+
+    std::remove(m_runs[t].m_fileName.c_str());
+  }
+}
+
+void te::qt::plugins::fiocruz::FlowPairAggregator::add(int from, int to, double weight, double distance)
+{
+  assert(!m_finished);
+
+  bool added;
+
+  int idx = m_pairs.add(makeKey(from, to), added);
+
+  if (added)
+  {
+    m_weight.push_back(weight);
+    m_distance.push_back(distance);
+    m_count.push_back(1);
+
+    if (m_pairs.size() >= m_maxPairs)
+      spill();
+
+    return;
+  }
+
+  m_weight[idx] += weight;
+  m_distance[idx] += distance;
+  m_count[idx] += 1;
+}
+
+void te::qt::plugins::fiocruz::FlowPairAggregator::finish()
+{
+  if (m_finished)
+    return;
+
+  m_finished = true;
+
+  if (m_runs.empty())
+  {
+    //the pairs are read sorted by key, so the order does not depend on the spills
+    std::size_t nPairs = m_pairs.size();
+
+    m_order.resize(nPairs);
+
+    for (std::size_t t = 0; t < nPairs; ++t)
+      m_order[t] = (int)t;
+
+    const IdDictionary<boost::int64_t>& pairs = m_pairs;
+
+    std::sort(m_order.begin(), m_order.end(), [&pairs](int a, int b) { return pairs.getId(a) < pairs.getId(b); });
+
+    return;
+  }
+
+  //the pairs still in memory become the last run
+  if (m_pairs.size() > 0)
+    spill();
+
+  //merge groups of runs until all of them can be open at the same time
+  while (m_runs.size() > MERGE_FAN_IN)
+  {
+    std::size_t nRuns = m_runs.size();
+
+    for (std::size_t first = 0; first < nRuns; first += MERGE_FAN_IN)
+      mergeRuns(first, std::min(first + MERGE_FAN_IN, nRuns));
+
+    //the merged runs were added after the source ones, whose files were removed
+    m_runs.erase(m_runs.begin(), m_runs.begin() + nRuns);
+  }
+
+  for (std::size_t t = 0; t < m_runs.size(); ++t)
+  {
+    openRun(t);
+
+    RunHead head;
+    head.m_run = t;
+
+    if (readRecord(t, head.m_record))
+      m_heads.push(head);
+  }
+}
+
+bool te::qt::plugins::fiocruz::FlowPairAggregator::next(AggregatedPair& pair)
+{
+  assert(m_finished);
+
+  boost::int64_t key;
+
+  if (m_runs.empty())
+  {
+    //nothing was spilled, the pairs come in key order
+    if (m_nextPair >= m_order.size())
+      return false;
+
+    int idx = m_order[m_nextPair];
+
+    key = m_pairs.getId(idx);
+
+    pair.m_weight = m_weight[idx];
+    pair.m_distance = m_distance[idx];
+    pair.m_count = m_count[idx];
+
+    ++m_nextPair;
+  }
+  else
+  {
+    //merge the records with the smallest key of all runs
+    if (m_heads.empty())
+      return false;
+
+    key = m_heads.top().m_record.m_key;
+
+    pair.m_weight = 0.;
+    pair.m_distance = 0.;
+    pair.m_count = 0;
+
+    while (!m_heads.empty() && m_heads.top().m_record.m_key == key)
+    {
+      RunHead head = m_heads.top();
+      m_heads.pop();
+
+      pair.m_weight += head.m_record.m_weight;
+      pair.m_distance += head.m_record.m_distance;
+      pair.m_count += head.m_record.m_count;
+
+      if (readRecord(head.m_run, head.m_record))
+        m_heads.push(head);
+    }
+  }
+
+  pair.m_from = (int)(key >> 32);
+  pair.m_to = (int)(boost::uint32_t)(key & 0xffffffff);
+
+  return true;
+}
+
+std::size_t te::qt::plugins::fiocruz::FlowPairAggregator::getRunCount() const
+{
+  return m_runs.size();
+}
+
+boost::int64_t te::qt::plugins::fiocruz::FlowPairAggregator::makeKey(int from, int to)
+{
+  //the pairs are indexes (not negative), so the key order is the (from, to) order
+  return ((boost::int64_t)from << 32) | (boost::uint32_t)to;
+}
+
+void te::qt::plugins::fiocruz::FlowPairAggregator::spill()
+{
+  std::size_t nPairs = m_pairs.size();
+
+  std::vector<int> order(nPairs);
+
+  for (std::size_t t = 0; t < nPairs; ++t)
+    order[t] = (int)t;
+
+  const IdDictionary<boost::int64_t>& pairs = m_pairs;
+
+  std::sort(order.begin(), order.end(), [&pairs](int a, int b) { return pairs.getId(a) < pairs.getId(b); });
+
+  std::ofstream out;
+
+  createRun(out);
+
+  for (std::size_t t = 0; t < nPairs; ++t)
+  {
+    RunRecord record;
+    record.m_key = m_pairs.getId(order[t]);
+    record.m_weight = m_weight[order[t]];
+    record.m_distance = m_distance[order[t]];
+    record.m_count = m_count[order[t]];
+
+    writeRecord(out, record);
+  }
+
+  out.close();
+
+  if (out.fail())
+    throw te::common::Exception(TE_TR("Error writing a temporary file to aggregate the flow records."));
+
+  m_pairs.clear();
+  m_weight.clear();
+  m_distance.clear();
+  m_count.clear();
+}
+
+void te::qt::plugins::fiocruz::FlowPairAggregator::createRun(std::ofstream& out)
+{
+  Run run;
+  run.m_fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("flowpairs-%%%%-%%%%-%%%%.run")).string();
+
+  out.open(run.m_fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open())
+    throw te::common::Exception(TE_TR("Could not create a temporary file to aggregate the flow records."));
+
+  m_runs.push_back(run);
+}
+
+void te::qt::plugins::fiocruz::FlowPairAggregator::openRun(std::size_t run)
+{
+  m_runs[run].m_stream.reset(new std::ifstream(m_runs[run].m_fileName.c_str(), std::ios::in | std::ios::binary));
+
+  if (!m_runs[run].m_stream->is_open())
+    throw te::common::Exception(TE_TR("Could not open a temporary file to aggregate the flow records."));
+}
+
+void te::qt::plugins::fiocruz::FlowPairAggregator::mergeRuns(std::size_t first, std::size_t last)
+{
+  std::priority_queue<RunHead> heads;
+
+  for (std::size_t t = first; t < last; ++t)
+  {
+    openRun(t);
+
+    RunHead head;
+    head.m_run = t;
+
+    if (readRecord(t, head.m_record))
+      heads.push(head);
+  }
+
+  std::ofstream out;
+
+  createRun(out);
+
+  //the records with the same key are summed, as in next()
+  while (!heads.empty())
+  {
+    RunRecord record = heads.top().m_record;
+    record.m_weight = 0.;
+    record.m_distance = 0.;
+    record.m_count = 0;
+
+    while (!heads.empty() && heads.top().m_record.m_key == record.m_key)
+    {
+      RunHead head = heads.top();
+      heads.pop();
+
+      record.m_weight += head.m_record.m_weight;
+      record.m_distance += head.m_record.m_distance;
+      record.m_count += head.m_record.m_count;
+
+      if (readRecord(head.m_run, head.m_record))
+        heads.push(head);
+    }
+
+    writeRecord(out, record);
+  }
+
+  out.close();
+
+  if (out.fail())
+    throw te::common::Exception(TE_TR("Error writing a temporary file to aggregate the flow records."));
+
+  for (std::size_t t = first; t < last; ++t)
+  {
+    m_runs[t].m_stream.reset();
+
+    std::remove(m_runs[t].m_fileName.c_str());
+  }
+}
+
+bool te::qt::plugins::fiocruz::FlowPairAggregator::readRecord(std::size_t run, RunRecord& record)
+{
+  std::ifstream& in = *m_runs[run].m_stream;
+
+  in.read(reinterpret_cast<char*>(&record), sizeof(RunRecord));
+
+  std::streamsize size = in.gcount();
+
+  //a partial record means the run file was truncated
+  if (size != 0 && size != (std::streamsize)sizeof(RunRecord))
+    throw te::common::Exception(TE_TR("Error reading a temporary file to aggregate the flow records."));
+
+  return size == (std::streamsize)sizeof(RunRecord);
+}
+
+void te::qt::plugins::fiocruz::FlowPairAggregator::writeRecord(std::ofstream& out, const RunRecord& record)
+{
+  out.write(reinterpret_cast<const char*>(&record), sizeof(RunRecord));
+}
@@ -0,0 +1,177 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/FlowPairAggregator.h
+
+\brief This file defines a class used to merge flow records with the same origin and destiny
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWPAIRAGGREGATOR_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWPAIRAGGREGATOR_H
+
+#include "../../Config.h"
+#include "IdDictionary.h"
+
+// STL
+#include <fstream>
+#include <queue>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \struct AggregatedPair
+
+        \brief Sum of all flow records of an origin / destiny pair.
+        */
+        struct AggregatedPair
+        {
+          int m_from;                   //!< Origin vertex
+          int m_to;                     //!< Destiny vertex
+          double m_weight;              //!< Sum of the record weights
+          double m_distance;            //!< Sum of the record distances
+          boost::uint64_t m_count;      //!< Number of records
+        };
+
+        /*!
+        \class FlowPairAggregator
+
+        \brief Merges flow records with the same (from, to) pair using a hash table with bounded size.
+
+        When the number of distinct pairs in memory reaches the limit, the pairs are
+        sorted and written to a temporary run file and the table is cleared. After
+        finish() the pairs are read with next(), always sorted by (from, to): the
+        pairs in memory are sorted or, if something was spilled, the runs are merged.
+        So the pair order does not depend on the memory limit. At most 64
+        runs are open at the same time, if there are more runs they are merged in
+        groups into new runs before reading.
+        */
+        class FlowPairAggregator
+        {
+          public:
+
+            /*!
+            \param maxPairs   Maximum number of distinct pairs kept in memory
+            */
+            FlowPairAggregator(std::size_t maxPairs);
+
+            ~FlowPairAggregator();
+
+          public:
+
+            /*! \brief Adds a flow record. */
+            void add(int from, int to, double weight, double distance);
+
+            /*! \brief Ends the insertion, it must be called before next(). */
+            void finish();
+
+            /*! \brief Gets the next aggregated pair, returns false when all pairs were read. */
+            bool next(AggregatedPair& pair);
+
+            /*! \brief Returns the number of run files, after finish() the runs that remain after the merge passes. */
+            std::size_t getRunCount() const;
+
+          protected:
+
+            /*!
+            \struct Run
+
+            \brief Temporary file with pairs sorted by key.
+            */
+            struct Run
+            {
+              std::string m_fileName;
+              boost::shared_ptr<std::ifstream> m_stream;
+            };
+
+            /*! \brief Record of a run file, all fields have 8 bytes so there is no padding. */
+            struct RunRecord
+            {
+              boost::int64_t m_key;
+              double m_weight;
+              double m_distance;
+              boost::uint64_t m_count;
+            };
+
+            /*! \brief Merge queue item, the smallest key is on top. */
+            struct RunHead
+            {
+              RunRecord m_record;
+              std::size_t m_run;
+
+              bool operator<(const RunHead& rhs) const
+              {
+                if (m_record.m_key != rhs.m_record.m_key)
+                  return m_record.m_key > rhs.m_record.m_key;
+
+                return m_run > rhs.m_run;
+              }
+            };
+
+            static boost::int64_t makeKey(int from, int to);
+
+            void spill();
+
+            /*! \brief Creates an empty run file, the run is added to m_runs so its file is always removed. */
+            void createRun(std::ofstream& out);
+
+            /*! \brief Opens the file of a run for reading, throws if it can not be opened. */
+            void openRun(std::size_t run);
+
+            /*! \brief Merges the runs [first, last) into a new run, the source files are closed and removed. */
+            void mergeRuns(std::size_t first, std::size_t last);
+
+            bool readRecord(std::size_t run, RunRecord& record);
+
+            static void writeRecord(std::ofstream& out, const RunRecord& record);
+
+          protected:
+
+            std::size_t m_maxPairs;                   //!< Limit of pairs in memory
+
+            IdDictionary<boost::int64_t> m_pairs;     //!< Pair key to position in the value columns
+            std::vector<double> m_weight;             //!< Weight sum of each pair in memory
+            std::vector<double> m_distance;           //!< Distance sum of each pair in memory
+            std::vector<boost::uint64_t> m_count;     //!< Record count of each pair in memory
+
+            std::vector<Run> m_runs;                  //!< Spilled runs
+            std::priority_queue<RunHead> m_heads;     //!< Current record of each run while merging
+
+            std::vector<int> m_order;                 //!< Positions of the pairs in memory sorted by key, when nothing was spilled
+            std::size_t m_nextPair;                   //!< Next position of m_order to be read
+            bool m_finished;
+        };
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_FLOWPAIRAGGREGATOR_H
@@ -0,0 +1,228 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/IdDictionary.h
+
+\brief This file defines a dictionary that maps external ids to dense indexes
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_IDDICTIONARY_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_IDDICTIONARY_H
+
+#include "../../Config.h"
+
+// STL
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/cstdint.hpp>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \struct IdHash
+
+        \brief Hash functions used by the IdDictionary, integer ids are mixed because
+               sparse codes (like IBGE municipality codes) share the low digits.
+        */
+        struct IdHash
+        {
+          std::size_t operator()(boost::int64_t id) const
+          {
+            boost::uint64_t h = (boost::uint64_t)id;
+
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+
+            return (std::size_t)h;
+          }
+
+          std::size_t operator()(const std::string& id) const
+          {
+            //FNV-1a
+            boost::uint64_t h = 14695981039346656037ULL;
+
+            for (std::size_t i = 0; i < id.size(); ++i)
+            {
+              h ^= (unsigned char)id[i];
+              h *= 1099511628211ULL;
+            }
+
+            return (std::size_t)h;
+          }
+        };
+
+        /*!
+        \class IdDictionary
+
+        \brief Maps external ids (integer or string) to dense indexes 0..N-1.
+
+        Indexes are given in insertion order and the original ids are kept, so
+        getId(getIndex(id)) == id. The table uses open addressing with linear
+        probing over a power of two slot array, each slot keeps only the dense
+        index of its id.
+        */
+        template<class Key, class Hash = IdHash>
+        class IdDictionary
+        {
+          public:
+
+            IdDictionary()
+            {
+              m_mask = 0;
+            }
+
+            /*!
+            \brief Returns the dense index of an id, the id is added if it is not in the dictionary.
+
+            \param id     External id
+            \param added  Set to true if the id was not in the dictionary
+
+            \return The dense index of the id.
+            */
+            int add(const Key& id, bool& added)
+            {
+              if ((m_keys.size() + 1) * 2 > m_slots.size())
+                rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+
+              std::size_t slot = m_hash(id) & m_mask;
+
+              while (m_slots[slot] != -1)
+              {
+                if (m_keys[m_slots[slot]] == id)
+                {
+                  added = false;
+                  return m_slots[slot];
+                }
+
+                slot = (slot + 1) & m_mask;
+              }
+
+              int idx = (int)m_keys.size();
+
+              m_slots[slot] = idx;
+              m_keys.push_back(id);
+
+              added = true;
+
+              return idx;
+            }
+
+            /*! \brief Returns the dense index of an id, the id is added if it is not in the dictionary. */
+            int add(const Key& id)
+            {
+              bool added;
+
+              return add(id, added);
+            }
+
+            /*! \brief Returns the dense index of an id or -1 if it is not in the dictionary. */
+            int getIndex(const Key& id) const
+            {
+              if (m_slots.empty())
+                return -1;
+
+              std::size_t slot = m_hash(id) & m_mask;
+
+              while (m_slots[slot] != -1)
+              {
+                if (m_keys[m_slots[slot]] == id)
+                  return m_slots[slot];
+
+                slot = (slot + 1) & m_mask;
+              }
+
+              return -1;
+            }
+
+            /*! \brief Returns the external id of a dense index. */
+            const Key& getId(int idx) const
+            {
+              return m_keys[idx];
+            }
+
+            std::size_t size() const
+            {
+              return m_keys.size();
+            }
+
+            /*! \brief Reserves space for n ids, avoiding rehash while they are added. */
+            void reserve(std::size_t n)
+            {
+              std::size_t capacity = 16;
+
+              while (capacity < n * 2)
+                capacity *= 2;
+
+              if (capacity > m_slots.size())
+                rehash(capacity);
+
+              m_keys.reserve(n);
+            }
+
+            void clear()
+            {
+              m_keys.clear();
+              m_slots.clear();
+              m_mask = 0;
+            }
+
+          protected:
+
+            void rehash(std::size_t capacity)
+            {
+              m_slots.assign(capacity, -1);
+              m_mask = capacity - 1;
+
+              for (std::size_t i = 0; i < m_keys.size(); ++i)
+              {
+                std::size_t slot = m_hash(m_keys[i]) & m_mask;
+
+                while (m_slots[slot] != -1)
+                  slot = (slot + 1) & m_mask;
+
+                m_slots[slot] = (int)i;
+              }
+            }
+
+          protected:
+
+            std::vector<Key> m_keys;      //!< External ids in dense index order
+            std::vector<int> m_slots;     //!< Hash slots with the dense index of an id or -1
+            std::size_t m_mask;           //!< Number of slots - 1
+            Hash m_hash;                  //!< Hash function
+        };
+
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_IDDICTIONARY_H
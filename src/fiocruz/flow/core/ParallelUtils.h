@@ -0,0 +1,109 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/ParallelUtils.h
+
+\brief This file defines helper functions used to split the flow algorithms between threads
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_PARALLELUTILS_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_PARALLELUTILS_H
+
+#include "../../Config.h"
+
+// STL
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \brief Returns the number of threads to be used.
+
+        \param requested  Number of threads requested by the user, 0 means one thread per core
+
+        \return A value greater than zero.
+        */
+        inline std::size_t GetThreadCount(std::size_t requested)
+        {
+          if (requested > 0)
+            return requested;
+
+          std::size_t hw = std::thread::hardware_concurrency();
+
+          return hw > 0 ? hw : 1;
+        }
+
+        /*!
+        \brief Splits the range [0, size) in contiguous chunks, one per thread.
+
+        The function is called as f(begin, end, threadIdx). The chunk of thread i
+        always precedes the chunk of thread i + 1, so results stored per thread can
+        be merged in thread order to get a deterministic output. The first chunk
+        runs in the calling thread.
+
+        \note The function must not throw, an exception inside a worker thread terminates the application.
+
+        \param size         Size of the range
+        \param numThreads   Number of threads (see GetThreadCount)
+        \param f            Function called for each chunk
+        */
+        template<typename Function>
+        void ParallelFor(std::size_t size, std::size_t numThreads, Function f)
+        {
+          numThreads = std::min(GetThreadCount(numThreads), size);
+
+          if (numThreads <= 1)
+          {
+            f((std::size_t)0, size, (std::size_t)0);
+            return;
+          }
+
+          std::size_t chunk = (size + numThreads - 1) / numThreads;
+
+          std::vector<std::thread> threads;
+
+          for (std::size_t t = 1; t < numThreads; ++t)
+          {
+            std::size_t begin = std::min(t * chunk, size);
+            std::size_t end = std::min(begin + chunk, size);
+
+            threads.push_back(std::thread(f, begin, end, t));
+          }
+
+          f((std::size_t)0, std::min(chunk, size), (std::size_t)0);
+
+          for (std::size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+        }
+
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_PARALLELUTILS_H
@@ -0,0 +1,56 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/StringPool.cpp
+
+\brief This file defines a pool of shared strings
+*/
+
+#include "StringPool.h"
+
+te::qt::plugins::fiocruz::StringPool::StringPool()
+{
+
+}
+
+te::qt::plugins::fiocruz::StringPool::~StringPool()
+{
+
+}
+
+boost::uint32_t te::qt::plugins::fiocruz::StringPool::add(const std::string& value)
+{
+  return (boost::uint32_t)m_strings.add(value);
+}
+
+const std::string& te::qt::plugins::fiocruz::StringPool::get(boost::uint32_t handle) const
+{
+  return m_strings.getId((int)handle);
+}
+
+std::size_t te::qt::plugins::fiocruz::StringPool::size() const
+{
+  return m_strings.size();
+}
+
+void te::qt::plugins::fiocruz::StringPool::reserve(std::size_t n)
+{
+  m_strings.reserve(n);
+}
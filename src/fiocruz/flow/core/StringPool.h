@@ -0,0 +1,82 @@
+/*  Copyright (C) 2011-2012 National Institute For Space Research (INPE) - Brazil.
+
+This file is part of the TerraLib - a Framework for building GIS enabled applications.
+
+TerraLib is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version.
+
+TerraLib is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TerraLib. See COPYING. If not, write to
+TerraLib Team at <terralib-team@terralib.org>.
+*/
+
+/*!
+\file fiocruz/src/fiocruz/flow/core/StringPool.h
+
+\brief This file defines a pool of shared strings
+*/
+
+#ifndef __FIOCRUZ_INTERNAL_FLOW_CORE_STRINGPOOL_H
+#define __FIOCRUZ_INTERNAL_FLOW_CORE_STRINGPOOL_H
+
+#include "../../Config.h"
+#include "IdDictionary.h"
+
+// STL
+#include <string>
+
+// Boost
+#include <boost/cstdint.hpp>
+
+namespace te
+{
+  namespace qt
+  {
+    namespace plugins
+    {
+      namespace fiocruz
+      {
+        /*!
+        \class StringPool
+
+        \brief Keeps one copy of each distinct string, the users keep 32 bits handles.
+
+        Handles are given in insertion order (0..N-1) and stay valid while the pool exists.
+        */
+        class StringPool
+        {
+          public:
+
+            StringPool();
+
+            ~StringPool();
+
+          public:
+
+            /*! \brief Returns the handle of a string, the string is added if it is not in the pool. */
+            boost::uint32_t add(const std::string& value);
+
+            /*! \brief Returns the string of a handle. */
+            const std::string& get(boost::uint32_t handle) const;
+
+            std::size_t size() const;
+
+            void reserve(std::size_t n);
+
+          protected:
+
+            IdDictionary<std::string> m_strings;    //!< Distinct strings in handle order
+        };
+      }   // end namespace fiocruz
+    }     // end namespace plugins
+  }       // end namespace qt
+}         // end namespace te
+
+#endif  // __FIOCRUZ_INTERNAL_FLOW_CORE_STRINGPOOL_H
@@ -34,6 +34,8 @@ TerraLib Team at <terralib-team@terralib.org>.
 #include <terralib/qt/widgets/layer/utils/DataSet2Layer.h>
 #include <terralib/qt/widgets/utils/ScopedCursor.h>
 #include <terralib/graph/Globals.h>
+#include <terralib/srs/Config.h>
+#include <terralib/srs/SpatialReferenceSystemManager.h>
 
 #include "../FlowGraphDiagramBuilder.h"
 #include "../FlowGraphExport.h"
@@ -60,6 +62,11 @@ m_ui(new Ui::FlowDiagramDialogForm)
   // add controls
   m_ui->setupUi(this);
 
+  //edge distance metric
+  m_ui->m_distanceTypeComboBox->addItem(tr("Planar"), QVariant((int)DISTANCE_PLANAR));
+  m_ui->m_distanceTypeComboBox->addItem(tr("Haversine (lat/long)"), QVariant((int)DISTANCE_HAVERSINE));
+  m_ui->m_distanceTypeComboBox->addItem(tr("Vincenty (lat/long)"), QVariant((int)DISTANCE_VINCENTY));
+
   //connects
   connect(m_ui->m_spatialLayerComboBox, SIGNAL(activated(int)), this, SLOT(onSpatialLayerComboBoxActivated(int)));
   connect(m_ui->m_tabularLayerComboBox, SIGNAL(activated(int)), this, SLOT(onTabularLayerComboBoxActivated(int)));
@@ -122,6 +129,9 @@ void te::qt::plugins::fiocruz::FlowDiagramDialog::onOkPushButtonClicked()
   int linkColumnName = m_ui->m_spatialPropertyNameComboBox->currentData().toInt();
   int srid = spatialLayer->getSRID();
 
+  if (!checkDistanceType(srid))
+    return;
+
   //get get input tabular info
   QVariant tabularVarLayer = m_ui->m_tabularLayerComboBox->currentData(Qt::UserRole);
   te::map::AbstractLayerPtr tabularLayer = tabularVarLayer.value<te::map::AbstractLayerPtr>();
@@ -172,6 +182,8 @@ void te::qt::plugins::fiocruz::FlowDiagramDialog::onOkPushButtonClicked()
   {
     te::qt::plugins::fiocruz::FlowGraphDiagramBuilder builder;
 
+    builder.setDistanceType((DistanceType)m_ui->m_distanceTypeComboBox->currentData().toInt());
+
     if (!builder.build(spatialDs, spatialDataSetName, linkColumnIdx, linkColumnName, srid, tabularDs, tabularDataSetName, fromIdx, toIdx, weightIdx, connInfo, graphType, graphInfo))
     {
       QMessageBox::warning(this, tr("Warning"), builder.getErrorMessage().c_str());
@@ -269,10 +281,16 @@ void te::qt::plugins::fiocruz::FlowDiagramDialog::onTabularLayerComboBoxActivate
   {
     te::dt::Property* prop = dsType->getProperties()[t];
 
-    if (prop->getType() == te::dt::INT32_TYPE || prop->getType() == te::dt::STRING_TYPE)
+    if (prop->getType() == te::dt::INT32_TYPE || prop->getType() == te::dt::INT64_TYPE || prop->getType() == te::dt::STRING_TYPE)
     {
       m_ui->m_tabularOriginComboBox->addItem(dsType->getProperties()[t]->getName().c_str(), QVariant(t));
       m_ui->m_tabularDestinyComboBox->addItem(dsType->getProperties()[t]->getName().c_str(), QVariant(t));
+    }
+
+    //the weight is read without truncation, so floating point columns are also accepted
+    if (prop->getType() == te::dt::INT32_TYPE || prop->getType() == te::dt::INT64_TYPE || prop->getType() == te::dt::STRING_TYPE ||
+        prop->getType() == te::dt::FLOAT_TYPE || prop->getType() == te::dt::DOUBLE_TYPE || prop->getType() == te::dt::NUMERIC_TYPE)
+    {
       m_ui->m_tabularWeightComboBox->addItem(dsType->getProperties()[t]->getName().c_str(), QVariant(t));
     }
   }
@@ -318,3 +336,34 @@ void te::qt::plugins::fiocruz::FlowDiagramDialog::onTargetFileToolButtonPressed(
 
   m_outputDatasource = dsInfoPtr;
 }
+
+bool te::qt::plugins::fiocruz::FlowDiagramDialog::checkDistanceType(int srid)
+{
+  DistanceType type = (DistanceType)m_ui->m_distanceTypeComboBox->currentData().toInt();
+
+  if (type == DISTANCE_PLANAR)
+    return true;
+
+  //the geodesic metrics read the coordinates as lat/long degrees
+  bool isGeographic = true;
+
+  try
+  {
+    te::srs::SpatialReferenceSystemManager& srsManager = te::srs::SpatialReferenceSystemManager::getInstance();
+
+    if (srid != TE_UNKNOWN_SRS && srsManager.recognizes((unsigned int)srid))
+      isGeographic = srsManager.isGeographic((unsigned int)srid);
+  }
+  catch (...)
+  {
+    //the SRID is not in the manager, the coordinates can not be checked
+  }
+
+  if (!isGeographic)
+  {
+    QMessageBox::warning(this, tr("Warning"), tr("The selected distance requires a lat/long layer, the layer projection is not geographic. Use the planar distance."));
+    return false;
+  }
+
+  return true;
+}
@@ -78,6 +78,11 @@ namespace te
 
           void onOkPushButtonClicked();
 
+        protected:
+
+          /*! \brief Returns false, after a warning, if a geodesic distance is selected for a layer with a projected SRID. */
+          bool checkDistanceType(int srid);
+
         private:
 
           std::auto_ptr<Ui::FlowDiagramDialogForm> m_ui;
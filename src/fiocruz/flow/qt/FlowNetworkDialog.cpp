@@ -41,6 +41,8 @@ TerraLib Team at <terralib-team@terralib.org>.
 #include <terralib/qt/widgets/layer/utils/DataSet2Layer.h>
 #include <terralib/qt/widgets/utils/ScopedCursor.h>
 #include <terralib/se/Utils.h>
+#include <terralib/srs/Config.h>
+#include <terralib/srs/SpatialReferenceSystemManager.h>
 
 // Qt
 #include <QMessageBox>
@@ -61,6 +63,11 @@ m_ui(new Ui::FlowNetworkDialogForm)
   // add controls
   m_ui->setupUi(this);
 
+  //edge distance metric, used when the flow layer has no distance column
+  m_ui->m_distanceTypeComboBox->addItem(tr("Planar"), QVariant((int)DISTANCE_PLANAR));
+  m_ui->m_distanceTypeComboBox->addItem(tr("Haversine (lat/long)"), QVariant((int)DISTANCE_HAVERSINE));
+  m_ui->m_distanceTypeComboBox->addItem(tr("Vincenty (lat/long)"), QVariant((int)DISTANCE_VINCENTY));
+
   //connects
   connect(m_ui->m_domLayerComboBox, SIGNAL(activated(int)), this, SLOT(onDomLayerComboBoxActivated(int)));
   connect(m_ui->m_targetFileToolButton, SIGNAL(pressed()), this, SLOT(onTargetFileToolButtonPressed()));
@@ -93,9 +100,8 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::setLayerList(std::list<te::map
     te::dt::Property* toProp = dsType->getProperty("to_id");
     te::dt::Property* toNameProp = dsType->getProperty("to_name");
     te::dt::Property* weightProp = dsType->getProperty("weight");
-    te::dt::Property* distProp = dsType->getProperty("distance");
-
-    if (fromProp && fromNameProp && toProp && toNameProp && weightProp && distProp)
+    //the distance column is optional, it is calculated on import if missing
+    if (fromProp && fromNameProp && toProp && toNameProp && weightProp)
       m_ui->m_flowLayerComboBox->addItem(l->getTitle().c_str(), QVariant::fromValue(l));
 
 
@@ -190,17 +196,26 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::onOkPushButtonClicked()
   //load graph
   QVariant flowVarLayer = m_ui->m_flowLayerComboBox->currentData(Qt::UserRole);
   te::map::AbstractLayerPtr flowLayer = flowVarLayer.value<te::map::AbstractLayerPtr>();
+
+  if (!checkDistanceType(flowLayer->getSRID()))
+    return;
+
   std::auto_ptr<te::da::DataSet> flowDataSet = flowLayer->getData();
 
   int flowGeomColumnIdx = te::da::GetFirstSpatialPropertyPos(flowDataSet.get());
 
   te::qt::plugins::fiocruz::FlowGraphImport fgi;
 
-  te::graph::AbstractGraph* graph = 0;
+  //parse the flow rows using one thread per core
+  fgi.setNumberOfThreads(0);
+
+  fgi.setDistanceType((DistanceType)m_ui->m_distanceTypeComboBox->currentData().toInt());
+
+  std::auto_ptr<te::qt::plugins::fiocruz::FlowGraph> graph;
 
   try
   {
-    graph = fgi.importGraph(flowDataSet, flowGeomColumnIdx, m_ui->m_outputStatisticsCheckBox->isChecked());
+    graph.reset(fgi.importGraph(flowDataSet, flowGeomColumnIdx, m_ui->m_outputStatisticsCheckBox->isChecked()));
   }
   catch (...)
   {
@@ -211,6 +226,8 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::onOkPushButtonClicked()
   //calculate dominance
   te::qt::plugins::fiocruz::FlowDominance fd;
 
+  fd.setNumberOfThreads(0);
+
   if (m_ui->m_domLayerRadioButton->isChecked())
   {
     QVariant varLayer = m_ui->m_domLayerComboBox->currentData(Qt::UserRole);
@@ -222,7 +239,10 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::onOkPushButtonClicked()
     int linkColumnIdx = m_ui->m_domPropertyIdxComboBox->currentData().toInt();
     int domColumnIdx = m_ui->m_domPropertyNameComboBox->currentData().toInt();
 
-    fd.associate(graph, ds, dataSetName, linkColumnIdx, domColumnIdx);
+    te::qt::plugins::fiocruz::DominanceJoinReport report = fd.associate(graph.get(), ds, dataSetName, linkColumnIdx, domColumnIdx);
+
+    if (report.m_matchedVertexCount == 0)
+      QMessageBox::warning(this, tr("Warning"), tr("No flow vertex matched the ids of the dominance layer."));
   }
   else if (m_ui->m_domCalcRadioButton->isChecked())
   {
@@ -233,59 +253,66 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::onOkPushButtonClicked()
     else if (m_ui->m_calculateInputRadioButton->isChecked())
       dt = te::qt::plugins::fiocruz::DOMINANCE_INPUTFLOW;
 
-    fd.calculate(graph, dt);
+    fd.calculate(graph.get(), dt);
   }
 
   //get main flow
   te::qt::plugins::fiocruz::CalculateMainFlow cmf;
 
+  cmf.setNumberOfThreads(0);
+
   try
   {
-    cmf.calculate(dynamic_cast<te::graph::BidirectionalGraph*>(graph), dominanceRelation, checkLocalDominance, localDominanceRelation, m_ui->m_outputStatisticsCheckBox->isChecked());
+    cmf.calculate(graph.get(), dominanceRelation, checkLocalDominance, localDominanceRelation, m_ui->m_outputStatisticsCheckBox->isChecked());
   }
   catch (const std::exception& e)
   {
     QMessageBox::warning(this, tr("Warning"), e.what());
 
-    graph->flush();
-
     return;
   }
   catch (...)
   {
     QMessageBox::warning(this, tr("Warning"), tr("Internal Error"));
 
-    graph->flush();
-
     return;
   }
 
+  //export, the edge and node data sets are written at the same time
+  std::string baseName = m_ui->m_newLayerNameLineEdit->text().toStdString();
+  std::string edgeDataSetName = baseName + "_edges";
+  std::string nodeDataSetName = baseName + "_nodes";
+
+  te::da::DataSourcePtr edgeDataSource = te::da::DataSourceManager::getInstance().get(m_outputDatasourceEdge->getId(), m_outputDatasourceEdge->getType(), m_outputDatasourceEdge->getConnInfo());
+  te::da::DataSourcePtr nodeDataSource = te::da::DataSourceManager::getInstance().get(m_outputDatasourceVertex->getId(), m_outputDatasourceVertex->getType(), m_outputDatasourceVertex->getConnInfo());
 
-  //export
   try
   {
-    exportEdges(graph);
+    te::qt::plugins::fiocruz::FlowGraphExport fge;
 
-    exportNodes(graph);
+    fge.exportGraph(edgeDataSource, edgeDataSetName, nodeDataSource, nodeDataSetName, graph.get());
   }
   catch (const std::exception& e)
   {
     QMessageBox::warning(this, tr("Warning"), e.what());
 
-    graph->flush();
-
     return;
   }
   catch (...)
   {
     QMessageBox::warning(this, tr("Warning"), tr("Internal Error"));
 
-    graph->flush();
-
     return;
   }
 
-  graph->flush();
+  graph.reset();
+
+  edgeDataSource->close();
+  nodeDataSource->close();
+
+  createEdgeLayers(edgeDataSetName);
+
+  createNodeLayers(nodeDataSetName);
 
   QMessageBox::information(this, tr("Information"), tr("Flow Network Created."));
 
@@ -329,6 +356,37 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::onTargetFileToolButtonPressed(
   m_ui->m_repositoryLineEdit->setText(fileName);
 }
 
+bool te::qt::plugins::fiocruz::FlowNetworkDialog::checkDistanceType(int srid)
+{
+  DistanceType type = (DistanceType)m_ui->m_distanceTypeComboBox->currentData().toInt();
+
+  if (type == DISTANCE_PLANAR)
+    return true;
+
+  //the geodesic metrics read the coordinates as lat/long degrees
+  bool isGeographic = true;
+
+  try
+  {
+    te::srs::SpatialReferenceSystemManager& srsManager = te::srs::SpatialReferenceSystemManager::getInstance();
+
+    if (srid != TE_UNKNOWN_SRS && srsManager.recognizes((unsigned int)srid))
+      isGeographic = srsManager.isGeographic((unsigned int)srid);
+  }
+  catch (...)
+  {
+    //the SRID is not in the manager, the coordinates can not be checked
+  }
+
+  if (!isGeographic)
+  {
+    QMessageBox::warning(this, tr("Warning"), tr("The selected distance requires a lat/long layer, the layer projection is not geographic. Use the planar distance."));
+    return false;
+  }
+
+  return true;
+}
+
 void te::qt::plugins::fiocruz::FlowNetworkDialog::createDataSources()
 {
   std::string path = m_ui->m_repositoryLineEdit->text().toStdString();
@@ -388,38 +446,8 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::createDataSources()
   }
 }
 
-void te::qt::plugins::fiocruz::FlowNetworkDialog::exportEdges(te::graph::AbstractGraph* graph)
+void te::qt::plugins::fiocruz::FlowNetworkDialog::createEdgeLayers(const std::string& dataSetName)
 {
-  std::string baseName = m_ui->m_newLayerNameLineEdit->text().toStdString();
-  std::string dataSetName = baseName + "_edges";
-
-  te::da::DataSourcePtr outputDataSource = te::da::DataSourceManager::getInstance().get(m_outputDatasourceEdge->getId(), m_outputDatasourceEdge->getType(), m_outputDatasourceEdge->getConnInfo());
-
-  te::qt::plugins::fiocruz::FlowGraphExport fge;
-
-  try
-  {
-    fge.exportGraph(outputDataSource, dataSetName, graph, te::qt::plugins::fiocruz::FLOWGRAPH_EDGE_TYPE);
-  }
-  catch (const std::exception& e)
-  {
-    QMessageBox::warning(this, tr("Warning"), e.what());
-
-    graph->flush();
-
-    return;
-  }
-  catch (...)
-  {
-    QMessageBox::warning(this, tr("Warning"), tr("Internal Error"));
-
-    graph->flush();
-
-    return;
-  }
-
-  outputDataSource->close();
-
   {
     //create layer
     te::da::DataSourcePtr ds = te::da::GetDataSource(m_outputDatasourceEdge->getId());
@@ -500,38 +528,8 @@ void te::qt::plugins::fiocruz::FlowNetworkDialog::exportEdges(te::graph::Abstrac
   }
 }
 
-void te::qt::plugins::fiocruz::FlowNetworkDialog::exportNodes(te::graph::AbstractGraph* graph)
+void te::qt::plugins::fiocruz::FlowNetworkDialog::createNodeLayers(const std::string& dataSetName)
 {
-  std::string baseName = m_ui->m_newLayerNameLineEdit->text().toStdString();
-  std::string dataSetName = baseName + "_nodes";
-
-  te::da::DataSourcePtr outputDataSource = te::da::DataSourceManager::getInstance().get(m_outputDatasourceVertex->getId(), m_outputDatasourceVertex->getType(), m_outputDatasourceVertex->getConnInfo());
-
-  te::qt::plugins::fiocruz::FlowGraphExport fge;
-
-  try
-  {
-    fge.exportGraph(outputDataSource, dataSetName, graph, te::qt::plugins::fiocruz::FLOWGRAPH_VERTEX_TYPE);
-  }
-  catch (const std::exception& e)
-  {
-    QMessageBox::warning(this, tr("Warning"), e.what());
-
-    graph->flush();
-
-    return;
-  }
-  catch (...)
-  {
-    QMessageBox::warning(this, tr("Warning"), tr("Internal Error"));
-
-    graph->flush();
-
-    return;
-  }
-
-  outputDataSource->close();
-
   {
     //create layer
     te::da::DataSourcePtr ds = te::da::GetDataSource(m_outputDatasourceVertex->getId());
@@ -28,9 +28,9 @@ TerraLib Team at <terralib-team@terralib.org>.
 
 // TerraLib
 #include <terralib/dataaccess/datasource/DataSourceInfo.h>
-#include <terralib/graph/core/AbstractGraph.h>
 #include <terralib/maptools/AbstractLayer.h>
 #include "../../Config.h"
+#include "../core/FlowGraph.h"
 
 // STL
 #include <memory>
@@ -79,11 +79,14 @@ namespace te
 
         protected:
 
+          /*! \brief Returns false, after a warning, if a geodesic distance is selected for a layer with a projected SRID. */
+          bool checkDistanceType(int srid);
+
           void createDataSources();
 
-          void exportEdges(te::graph::AbstractGraph* graph);
+          void createEdgeLayers(const std::string& dataSetName);
 
-          void exportNodes(te::graph::AbstractGraph* graph);
+          void createNodeLayers(const std::string& dataSetName);
 
         private:
 
@@ -24,6 +24,7 @@ TerraLib Team at <terralib-team@terralib.org>.
 */
 
 #include "RasterInterpolate.h"
+#include "../CentroidCache.h"
 #include "SimpleMemDataSet.h"
 #include "Utils.h"
 
@@ -110,49 +111,17 @@ te::qt::plugins::fiocruz::Ocurrencies te::qt::plugins::fiocruz::GetOcurrencies(c
 }
 te::qt::plugins::fiocruz::Ocurrencies te::qt::plugins::fiocruz::GetOcurrencies(const ComplexDataSet& ocurrenciesDataDriver, const std::string& destinyIdColumnName, const std::string& originLinkColumnName, const ComplexDataSet& originDataDriver, const std::string& originIdColumnName, const std::string& destinyIdFilter)
 {
-  Ocurrencies ocurrencies;
-  //we first get the centroids from the polygons of the originDataSet and create a map
-  te::da::DataSet* ocurrenciesDataSet = ocurrenciesDataDriver.getDataSet();
-  te::da::DataSetType* ocurrenciesDataSetType = ocurrenciesDataDriver.getDataSetType();
-
-  te::da::DataSet* originDataSet = originDataDriver.getDataSet();
-  te::da::DataSetType* originDataSetType = originDataDriver.getDataSetType();
-  te::gm::GeometryProperty* originGeometryProperty = te::da::GetFirstGeomProperty(originDataSetType);
-  te::gm::GeomType geomType = originGeometryProperty->getGeometryType();
-
-  std::map<std::string, te::gm::Coord2D> mapOriginCentroids;
-
-  originDataSet->moveBeforeFirst();
-  while (originDataSet->moveNext())
-  {
-    std::string originId = originDataSet->getString(originIdColumnName);
+  //the centroids of the polygons of the originDataSet are computed for this call only
+  boost::shared_ptr<const CentroidTable> originCentroids = CentroidCache::getInstance().compute(originDataDriver.getDataSet(), originIdColumnName);
 
-    std::auto_ptr<te::gm::Geometry> geometry = originDataSet->getGeometry(originGeometryProperty->getName());
-    if (geomType == te::gm::GeomType::PolygonType)
-    {
-      te::gm::Polygon* polygon = dynamic_cast<te::gm::Polygon*>(geometry.get());
-      if (polygon == 0)
-      {
-        continue;
-      }
+  return GetOcurrencies(ocurrenciesDataDriver, destinyIdColumnName, originLinkColumnName, *originCentroids, destinyIdFilter);
+}
 
-      std::auto_ptr<te::gm::Coord2D> centroid(polygon->getCentroidCoord());
-      te::gm::Coord2D coord = te::gm::Coord2D(centroid->getX(), centroid->getY());
-      mapOriginCentroids[originId] = coord;
-    }
-    else if (geomType == te::gm::GeomType::MultiPolygonType)
-    {
-      te::gm::MultiPolygon* polygon = dynamic_cast<te::gm::MultiPolygon*>(geometry.get());
-      if (polygon == 0)
-      {
-        continue;
-      }
+te::qt::plugins::fiocruz::Ocurrencies te::qt::plugins::fiocruz::GetOcurrencies(const ComplexDataSet& ocurrenciesDataDriver, const std::string& destinyIdColumnName, const std::string& originLinkColumnName, const CentroidTable& originCentroids, const std::string& destinyIdFilter)
+{
+  Ocurrencies ocurrencies;
 
-      std::auto_ptr<te::gm::Coord2D> centroid(polygon->getCentroidCoord());
-      te::gm::Coord2D coord = te::gm::Coord2D(centroid->getX(), centroid->getY());
-      mapOriginCentroids[originId] = coord;
-    }
-  }
+  te::da::DataSet* ocurrenciesDataSet = ocurrenciesDataDriver.getDataSet();
 
   //now we create the ocurrencies map
   ocurrenciesDataSet->moveBeforeFirst();
@@ -165,15 +134,15 @@ te::qt::plugins::fiocruz::Ocurrencies te::qt::plugins::fiocruz::GetOcurrencies(c
     }
 
     std::string originId = ocurrenciesDataSet->getString(originLinkColumnName);
-    std::map<std::string, te::gm::Coord2D>::iterator itOrigin = mapOriginCentroids.find(originId);
-    if (itOrigin == mapOriginCentroids.end())
+
+    double x = 0.;
+    double y = 0.;
+
+    if (originCentroids.getPoint(originId, x, y) == false)
     {
       continue;
     }
 
-    double x = itOrigin->second.getX();
-    double y = itOrigin->second.getY();
-
     te::gm::Coord2D coord(x, y);
 
     Ocurrencies::iterator it = ocurrencies.find(destinyId);
@@ -50,6 +50,7 @@ namespace te
       namespace fiocruz
       {
 
+        class CentroidTable;
         class ComplexDataSet;
 
         typedef std::vector<te::gm::Coord2D> CoordVector;
@@ -59,6 +60,9 @@ namespace te
         Ocurrencies GetOcurrencies(const ComplexDataSet& ocurrenciesDataDriver, const std::string& destinyIdColumnName, const std::string& xColumnName, const std::string& yColumnName, const std::string& destinyIdFilter);
         Ocurrencies GetOcurrencies(const ComplexDataSet& ocurrenciesDataDriver, const std::string& destinyIdColumnName, const std::string& originLinkColumnName, const ComplexDataSet& originDataDriver, const std::string& originIdColumnName, const std::string& destinyIdFilter);
 
+        //! Gets the coordinates of all ocurrencies grouping by id, the origin coordinates come from a centroid table (see CentroidCache).
+        Ocurrencies GetOcurrencies(const ComplexDataSet& ocurrenciesDataDriver, const std::string& destinyIdColumnName, const std::string& originLinkColumnName, const CentroidTable& originCentroids, const std::string& destinyIdFilter);
+
         te::gm::Geometry* unitePolygonsFromDataSet(const ComplexDataSet& complexDataSet);
 
         //! Builds a KDTree from a theme with samples: the theme must have a point representation
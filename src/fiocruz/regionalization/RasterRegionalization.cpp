@@ -26,6 +26,7 @@ TerraLib Team at <terralib-team@terralib.org>.
 #include "RasterRegionalization.h"
 
 #include "RasterInterpolate.h"
+#include "../CentroidCache.h"
 #include "SimpleMemDataSet.h"
 #include "Utils.h"
 
@@ -95,6 +96,14 @@ bool te::qt::plugins::fiocruz::RasterRegionalization::generate(std::vector<std::
   std::string path = m_outputParams->m_path;
   std::string baseName = m_outputParams->m_baseName;
 
+  //the origin centroids are the same for all destinies
+  boost::shared_ptr<const CentroidTable> originCentroids;
+
+  if (hasSpatialInformation == false)
+  {
+    originCentroids = CentroidCache::getInstance().getTable(m_inputParams->m_iVectorDataSource, m_inputParams->m_iVectorDataSetName, vecColumnOriginId);
+  }
+
   std::auto_ptr<te::gm::Geometry> geometry(unitePolygonsFromDataSet(vecDataDriver));
   te::gm::MultiPolygon* multiPolygon = dynamic_cast<te::gm::MultiPolygon*>(geometry.get());
   if (multiPolygon == 0)
@@ -117,7 +126,7 @@ bool te::qt::plugins::fiocruz::RasterRegionalization::generate(std::vector<std::
     }
     else
     {
-      ocurrencies = GetOcurrencies(tabDataDriver, tabColumnDestinyId, tabColumnOriginId, vecDataDriver, vecColumnOriginId, currentDestiny);
+      ocurrencies = GetOcurrencies(tabDataDriver, tabColumnDestinyId, tabColumnOriginId, *originCentroids, currentDestiny);
     }
     KernelInterpolationAlgorithm algorithm = m_inputParams->m_algorithm;
 
@@ -23,6 +23,7 @@ TerraLib Team at <terralib-team@terralib.org>.
 \brief This class defines the representation of a Regionalization Map
 */
 
+#include "../ColumnReader.h"
 #include "RegionalizationMap.h"
 
 #include <set>
@@ -47,13 +48,22 @@ bool te::qt::plugins::fiocruz::RegionalizationMap::init(te::da::DataSetPtr dataS
 
   m_originMap.clear();
 
+  //the column positions and types are resolved only once
+  ColumnReader originReader(dataSet.get(), columnOrigin);
+  ColumnReader destinyReader(dataSet.get(), columnDestiny);
+
+  if (!originReader.isValid() || !destinyReader.isValid())
+  {
+    return false;
+  }
+
   //for all ocorrencies in the dataset
   while (dataSet->moveNext())
   {
-    std::string origin = dataSet->getString(columnOrigin);
-    std::string destiny = dataSet->getString(columnDestiny);
+    //the destiny is checked first, so the origin is only read for the filtered rows
+    std::string destiny = destinyReader.getString();
 
-    if (origin.empty() || destiny.empty())
+    if (destiny.empty())
       continue;
 
     if (setFilterDestinyIds.find(destiny) == setFilterDestinyIds.end())
@@ -61,6 +71,11 @@ bool te::qt::plugins::fiocruz::RegionalizationMap::init(te::da::DataSetPtr dataS
       continue;
     }
 
+    std::string origin = originReader.getString();
+
+    if (origin.empty())
+      continue;
+
     //we fist check if there is already any occurrency from the current origin
     OriginMap::iterator itOrigin = m_originMap.find(origin);
     if (itOrigin == m_originMap.end())